@@ -4,59 +4,511 @@
  * Author: DannyBimma
  *
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * To compile: gcc -std=c99 -O2 day1.c -pthread -o day1
+ *
+ * Usage: day1 [--verify] [--dial modulus[@start] ...] [rotation log]
+ *        day1 --stream [--interval seconds] [--dial ...] [source]
+ *
+ * --dial adds a dial of any modulus up to 2^30, starting at start (0 by
+ * default); repeat it for more dials, up to 64. Without it there is one
+ * dial of 100 starting at 50, as in the puzzle. With several dials, a line
+ * like "2: R15" turns dial 2 and a line with no number turns dial 0, and
+ * every dial gets its own password.
+ *
+ * --stream reads rotations from source, stdin by default or a FIFO, as they
+ * arrive, in constant memory. Every interval (1 second by default, 0 for
+ * never) it prints the password so far with the lines/s and bytes/s since
+ * the last report, and how busy the parser was; near 100% means it's the
+ * bottleneck rather than the producer.
+ *
+ * --verify also runs every chunk through the scalar reference and fails if
+ * the kernel disagrees.
+ *
+ * With AOC_INPUT_CACHE set, the parsed chunks are kept in the input cache
+ * (see input_cache.h), so a second run on the same log and dials goes
+ * straight to the kernels. With AOC_RESULT_CACHE set, batch runs keep their
+ * passwords too (see result_cache.h) and a repeat skips the kernels as well.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "day1_dial.h"
+#include "input_cache.h"
+#include "result_cache.h"
+#include "work_pool.h"
+
+#define CHUNK_BYTES (1 << 20)  // Rotation log parsed per task
+#define STREAM_BUFFER (1 << 16) // Bytes read at a time when streaming
+#define DAY1_INPUT_KIND INPUT_CACHE_KIND(1, 1)
+#define DAY1_RESULT_VERSION 1
+
+// The rotation log, its chunks, and the zeros each chunk reaches
+// Chunk i's rotations for dial d are at chunks[i * num_dials + d].
+typedef struct {
+  const char *text;
+  size_t size;
+  int num_chunks;
+  DialChunk *chunks;
+  bool *failed; // Chunks that ran out of memory while parsing
+  long long *zeros;
+  long long *reference; // The same through the reference, with --verify
+} RotationLog;
+
+// A chunk's deltas in the input cache, at deltas[first .. first + count)
+typedef struct {
+  uint64_t first, count;
+  int64_t turns, net;
+} CachedChunk;
+
+// Running totals while streaming
+typedef struct {
+  int positions[MAX_DIALS];
+  long long counts[MAX_DIALS];
+  long long count; // Across all dials
+  long long lines, bytes;
+  double busy; // Seconds spent parsing
+} DialStream;
+
+Dial dials[MAX_DIALS];
+int num_dials = 0;
+
+// Off unless a batch run looks its result up
+ResultCache results;
+
+int add_dial(const char *spec);
+uint64_t dial_params(void);
+int load_chunks(RotationLog *log, const InputCache *input);
+void store_chunks(const RotationLog *log, InputCache *input);
+void parse_task(void *ctx, int index);
+void run_task(void *ctx, int index);
+int stream_rotations(const char *source, double interval);
+void print_passwords(const long long *counts);
+void stream_lines(DialStream *stream, const char *text, size_t size);
+void report_stream(FILE *out, const char *label, const DialStream *now,
+                   const DialStream *last, double seconds);
+double seconds_since(const struct timespec *start);
+
+int main(int argc, char *argv[]) {
+  bool stream = false, verify = false;
+  const char *source = NULL;
+  double interval = 1.0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--stream") == 0) {
+      stream = true;
+    } else if (strcmp(argv[i], "--verify") == 0) {
+      verify = true;
+    } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+      interval = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--dial") == 0 && i + 1 < argc) {
+      if (!add_dial(argv[++i])) {
+        fprintf(stderr,
+                "Error: Invalid dial '%s' (want modulus[@start], modulus 1 "
+                "to %d, at most %d dials)\n",
+                argv[i], DIAL_MAX_SIZE, MAX_DIALS);
+
+        return 1;
+      }
+    } else {
+      source = argv[i];
+    }
+  }
+
+  if (num_dials == 0)
+    dial_init(&dials[num_dials++], DIAL_SIZE, DIAL_START);
+
+  if (stream)
+    return stream_rotations(source ? source : "-", interval);
 
-int main() {
-  char line[5000];
-  int position = 50;
-  int count = 0;
+  const char *filename = source ? source : "day1_input.txt";
 
-  // Open and read file
-  FILE *secretSauce = fopen("day1_input.txt", "r");
-  if (secretSauce == NULL) {
+  // A repeat run on the same log and dials just replays the passwords;
+  // --verify is there to run the kernels, so it always does
+  if (!verify && result_cache_open(&results, filename, 1, 1,
+                                   DAY1_RESULT_VERSION, argc, argv))
+    return 0;
+
+  // Map the file, and its parsed chunks if there's a cache file for them
+  InputCache input;
+
+  if (!input_cache_open(&input, filename, DAY1_INPUT_KIND, dial_params())) {
     fprintf(stderr, "Error: Could not open input file\n");
 
     return 1;
   }
 
-  // Scan rotation instructions line by line
-  while (fgets(line, sizeof(line), secretSauce)) {
-    char direction;
-    int distance;
-
-    // Count how many times 0 is passed during this rotation
-    if (sscanf(line, " %c%d", &direction, &distance) == 2) {
-      int zeros_during_rotation = 0;
-
-      // R: count how many times rotation goes from 99 to 0
-      if (direction == 'R') {
-        zeros_during_rotation = (position + distance) / 100;
-      } else {
-        // L: count how many times rotation goes from 0 to 99
-        if (position > 0 && distance >= position) {
-          zeros_during_rotation = (distance - position) / 100 + 1;
-        } else if (position == 0) {
-          zeros_during_rotation = distance / 100;
-        }
-      }
+  RotationLog log = {input.text, input.size, 0, NULL, NULL, NULL, NULL};
+  log.num_chunks = (int)((log.size + CHUNK_BYTES - 1) / CHUNK_BYTES);
+
+  size_t runs = (size_t)(log.num_chunks ? log.num_chunks : 1) * num_dials;
+
+  log.chunks = calloc(runs, sizeof(DialChunk));
+  log.failed = calloc(runs, sizeof(bool));
+  log.zeros = malloc(runs * sizeof(long long));
+  if (verify)
+    log.reference = malloc(runs * sizeof(long long));
+
+  if (!log.chunks || !log.failed || !log.zeros || (verify && !log.reference)) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
+
+    return 1;
+  }
+
+  if (input_cache_hit(&input) && !load_chunks(&log, &input))
+    input_cache_reject(&input);
+
+  bool cached = input_cache_hit(&input);
+
+  if (!cached) {
+    // Parse the chunks into deltas across all cores
+    pool_run(log.num_chunks, parse_task, &log);
 
-      count += zeros_during_rotation;
+    for (int i = 0; i < log.num_chunks; i++) {
+      if (log.failed[i]) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
 
-      // Apply rotation with modulo arithmetic for wrapping
-      if (direction == 'L') {
-        position = ((position - distance) % 100 + 100) % 100;
-      } else if (direction == 'R') {
-        position = (position + distance) % 100;
+        return 1;
       }
     }
+
+    store_chunks(&log, &input);
+  }
+
+  // Scan each dial's net offsets for where its chunks start
+  for (int d = 0; d < num_dials; d++) {
+    int position = dials[d].start;
+
+    for (int i = 0; i < log.num_chunks; i++) {
+      DialChunk *chunk = &log.chunks[i * num_dials + d];
+
+      chunk->start = position;
+      position = (position + dial_offset(chunk, &dials[d])) % dials[d].modulus;
+    }
+  }
+
+  // Then every chunk runs from its start, again across all cores
+  pool_run(log.num_chunks * num_dials, run_task, &log);
+
+  long long counts[MAX_DIALS] = {0};
+  int mismatches = 0;
+
+  for (int i = 0; i < log.num_chunks * num_dials; i++) {
+    counts[i % num_dials] += log.zeros[i];
+    mismatches += verify && log.reference[i] != log.zeros[i];
+    if (!cached)
+      free(log.chunks[i].deltas);
   }
 
-  fclose(secretSauce);
+  input_cache_close(&input);
+  free(log.chunks);
+  free(log.failed);
+  free(log.zeros);
+  free(log.reference);
+
+  if (mismatches) {
+    fprintf(stderr,
+            "Error: Kernel disagrees with the scalar reference on %d "
+            "chunks\n",
+            mismatches);
+
+    return 1;
+  }
 
-  printf("Password: %d\n", count);
+  print_passwords(counts);
+  result_cache_finish(&results);
 
   return 0;
 }
+
+// Add a dial from "modulus[@start]", return 0 if it's invalid
+int add_dial(const char *spec) {
+  char *end;
+  long modulus = strtol(spec, &end, 10), start = 0;
+
+  if (end == spec)
+    return 0;
+
+  if (*end == '@') {
+    const char *at = end + 1;
+
+    start = strtol(at, &end, 10);
+    if (end == at)
+      return 0;
+  }
+
+  if (*end != '\0' || num_dials == MAX_DIALS || modulus < 1 ||
+      modulus > DIAL_MAX_SIZE || start < 0 || start >= modulus)
+    return 0;
+
+  return dial_init(&dials[num_dials++], (int)modulus, (int)start);
+}
+
+// What the cached chunks depend on besides the input: how it's split, and
+// each dial's modulus
+uint64_t dial_params(void) {
+  int64_t params[MAX_DIALS + 2] = {CHUNK_BYTES, num_dials};
+
+  for (int d = 0; d < num_dials; d++)
+    params[2 + d] = dials[d].modulus;
+
+  return input_cache_hash(params, (num_dials + 2) * sizeof(int64_t));
+}
+
+// Point the chunks at the deltas in the cache file, return 0 if they don't
+// fit the log
+int load_chunks(RotationLog *log, const InputCache *input) {
+  size_t records_size, deltas_size;
+  const CachedChunk *records = input_cache_section(input, 0, &records_size);
+  const int32_t *deltas = input_cache_section(input, 1, &deltas_size);
+  size_t runs = (size_t)log->num_chunks * num_dials;
+  uint64_t total = deltas_size / sizeof(int32_t);
+
+  if (!records || !deltas || records_size != runs * sizeof(CachedChunk))
+    return 0;
+
+  for (size_t i = 0; i < runs; i++)
+    if (records[i].first > total || records[i].count > total - records[i].first)
+      return 0;
+
+  for (size_t i = 0; i < runs; i++) {
+    DialChunk *chunk = &log->chunks[i];
+
+    // Read only: the kernels never write through deltas
+    chunk->deltas = (int32_t *)(deltas + records[i].first);
+    chunk->count = records[i].count;
+    chunk->turns = records[i].turns;
+    chunk->net = records[i].net;
+  }
+
+  return 1;
+}
+
+// Save the parsed chunks for the next run on the same log
+void store_chunks(const RotationLog *log, InputCache *input) {
+  size_t runs = (size_t)log->num_chunks * num_dials;
+  uint64_t first = 0;
+
+  input_cache_begin(input);
+
+  for (size_t i = 0; i < runs; i++) {
+    const DialChunk *chunk = &log->chunks[i];
+    CachedChunk record = {first, chunk->count, chunk->turns, chunk->net};
+
+    input_cache_append(input, 0, &record, sizeof(record));
+    first += chunk->count;
+  }
+
+  for (size_t i = 0; i < runs; i++)
+    input_cache_append(input, 1, log->chunks[i].deltas,
+                       log->chunks[i].count * sizeof(int32_t));
+
+  input_cache_commit(input);
+}
+
+void parse_task(void *ctx, int index) {
+  RotationLog *log = ctx;
+  size_t begin = (size_t)index * CHUNK_BYTES;
+  size_t end = begin + CHUNK_BYTES < log->size ? begin + CHUNK_BYTES
+                                               : log->size;
+
+  // Reported after the batch
+  log->failed[index] =
+      !dial_parse_chunk(log->text, log->size, begin, end, dials, num_dials,
+                        &log->chunks[(size_t)index * num_dials]);
+}
+
+void run_task(void *ctx, int index) {
+  RotationLog *log = ctx;
+  const DialChunk *chunk = &log->chunks[index];
+  const Dial *dial = &dials[index % num_dials];
+
+  log->zeros[index] = dial_run_chunk(chunk, dial);
+
+  if (log->reference)
+    log->reference[index] = dial_check_chunk(chunk, dial);
+}
+
+// One password, or one line per dial when there are several
+void print_passwords(const long long *counts) {
+  if (num_dials == 1) {
+    result_printf(&results, "Password: %lld\n", counts[0]);
+
+    return;
+  }
+
+  for (int d = 0; d < num_dials; d++)
+    result_printf(&results, "Dial %d (modulus %d from %d): Password: %lld\n",
+                  d, dials[d].modulus, dials[d].start, counts[d]);
+}
+
+// Apply rotations as they arrive, reporting every interval seconds
+// Only whole lines are parsed; a partial one waits in the buffer for the
+// rest, and one longer than the buffer is cut short. Returns the exit status.
+int stream_rotations(const char *source, double interval) {
+  int fd = strcmp(source, "-") == 0 ? STDIN_FILENO : open(source, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Error: Could not open %s\n", source);
+
+    return 1;
+  }
+
+  static char buffer[STREAM_BUFFER];
+  size_t used = 0;
+  bool skipping = false; // Dropping the rest of an overlong line
+  DialStream stream = {{0}, {0}, 0, 0, 0, 0.0};
+  DialStream last;
+  struct timespec start;
+  double last_report = 0.0;
+  int status = 0;
+
+  for (int d = 0; d < num_dials; d++)
+    stream.positions[d] = dials[d].start;
+  last = stream;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (;;) {
+    double elapsed = seconds_since(&start);
+    int timeout = -1;
+
+    if (interval > 0) {
+      if (elapsed - last_report >= interval) {
+        report_stream(stdout, "Password so far", &stream, &last,
+                      elapsed - last_report);
+        last = stream;
+        last_report = elapsed;
+      }
+
+      timeout = (int)((last_report + interval - elapsed) * 1000) + 1;
+    }
+
+    // Wake for the next report even if the producer stalls
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeout);
+
+    if (ready == 0 || (ready < 0 && errno == EINTR))
+      continue;
+
+    ssize_t got = -1;
+    if (ready > 0)
+      got = read(fd, buffer + used, sizeof(buffer) - used);
+
+    if (got < 0 && errno == EINTR)
+      continue;
+
+    if (got < 0) {
+      fprintf(stderr, "Error: Could not read %s: %s\n", source,
+              strerror(errno));
+      status = 1;
+      break;
+    }
+
+    if (got == 0)
+      break;
+
+    struct timespec parse_start;
+    clock_gettime(CLOCK_MONOTONIC, &parse_start);
+
+    stream.bytes += got;
+    used += got;
+
+    char *text = buffer;
+
+    if (skipping) {
+      char *newline = memchr(text, '\n', used);
+
+      skipping = newline == NULL;
+      text = newline ? newline + 1 : text + used;
+    }
+
+    // Parse up to the last newline and keep the rest for the next read
+    size_t left = used - (text - buffer);
+    char *tail = text + left;
+
+    while (tail > text && tail[-1] != '\n')
+      tail--;
+
+    if (tail == text && left == sizeof(buffer)) {
+      // A line filling the whole buffer: take what's here, drop the rest
+      stream_lines(&stream, text, left);
+      skipping = true;
+      tail = text + left;
+    } else {
+      stream_lines(&stream, text, tail - text);
+    }
+
+    used = left - (tail - text);
+    memmove(buffer, tail, used);
+
+    stream.busy += seconds_since(&parse_start);
+  }
+
+  // A last line without a newline
+  if (status == 0 && used > 0 && !skipping)
+    stream_lines(&stream, buffer, used);
+
+  if (fd != STDIN_FILENO)
+    close(fd);
+
+  double elapsed = seconds_since(&start);
+  DialStream none = {{0}, {0}, 0, 0, 0, 0.0};
+
+  print_passwords(stream.counts);
+  report_stream(stderr, "Streamed password", &stream, &none, elapsed);
+
+  return status;
+}
+
+// Apply every line in text
+void stream_lines(DialStream *stream, const char *text, size_t size) {
+  const char *p = text, *end = text + size;
+
+  while (p < end) {
+    int d;
+    char direction;
+    long long distance;
+
+    if (dial_parse(&p, end, &d, &direction, &distance) && d < num_dials) {
+      long long zeros = dial_rotate(&stream->positions[d], direction,
+                                    distance, dials[d].modulus);
+
+      stream->counts[d] += zeros;
+      stream->count += zeros;
+    }
+
+    stream->lines++;
+  }
+}
+
+// Password so far and throughput since the last report
+void report_stream(FILE *out, const char *label, const DialStream *now,
+                   const DialStream *last, double seconds) {
+  if (seconds <= 0)
+    seconds = 1e-9;
+
+  fprintf(out,
+          "%s: %lld after %lld lines (%.0f lines/s, %.2f MB/s, parser busy "
+          "%.0f%%)\n",
+          label, now->count, now->lines, (now->lines - last->lines) / seconds,
+          (now->bytes - last->bytes) / seconds / 1e6,
+          100 * (now->busy - last->busy) / seconds);
+  fflush(out);
+}
+
+double seconds_since(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
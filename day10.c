@@ -4,177 +4,647 @@
  * Author: DannyBimma
  *
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * To compile: gcc -std=c99 -O2 day10.c -pthread -o day10
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_LIGHTS 16
-#define MAX_BUTTONS 32
-#define MAX_LINE 1024
+#include "day10_machines.h"
+#include "result_cache.h"
+#include "work_pool.h"
+
+#define MITM_MAX_HALF 22    // Largest half enumerated by meet-in-the-middle
+#define BFS_MAX_RANK 24     // Most independent patterns searched breadth-first
+#define GRAY_MAX_NULLITY 24 // Largest null space walked in full
+#define DAY10_RESULT_VERSION 1
 
-// Create a structure to represent the machine
-// With the state of lights and button effects
+// Bytes the meet-in-the-middle tables of all workers may take at once
+#define MITM_MEMORY (1L << 30)
+
+// Every machine in the input, and the fewest presses found for each
 typedef struct {
-  int num_lights;
-  unsigned int target; // Bit pattern for target configuration
-  int num_buttons;
-  unsigned int buttons[MAX_BUTTONS]; // Each button's effect as bit pattern
-} Machine;
+  MachineArena arena;
+  int *presses;
+} Batch;
+
+// Each worker's share of MITM_MEMORY, since they all search at once
+size_t mitm_budget = MITM_MEMORY;
 
-int count_bits(unsigned int n);
-int parse_machine(const char *line, Machine *machine);
-int machine_diagnostic(Machine *machine);
+int machine_diagnostic(const MachineView *machine);
+int diagnose_1(const MachineView *machine);
+int diagnose_2(const MachineView *machine);
+int diagnose_4(const MachineView *machine);
+int diagnose_any(const MachineView *machine);
+void diagnose_task(void *ctx, int index);
 
 int main(void) {
-  // Open puzzle input file for reading
-  FILE *fp = fopen("day10_input.txt", "r");
-  if (!fp) {
-    perror("Error opening file");
+  ResultCache results;
+  if (result_cache_open(&results, "day10_input.txt", 10, 1,
+                        DAY10_RESULT_VERSION, 0, NULL))
+    return 0;
+
+  // Parse the whole batch up front
+  Batch batch;
+  if (!load_machines(&batch.arena, "day10_input.txt"))
+    return 1;
+
+  int count = batch.arena.count;
+  batch.presses = malloc((count ? count : 1) * sizeof(int));
+  if (!batch.presses) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
 
     return 1;
   }
 
-  // Init main variables
-  char line[MAX_LINE];
+  // Machines are independent, so solve them across all cores
+  mitm_budget = MITM_MEMORY / pool_num_workers();
+  pool_run(count, diagnose_task, &batch);
+
+  // Tally in input order
   int total_presses = 0;
   int machine_count = 0;
 
-  while (fgets(line, sizeof(line), fp)) {
-    // Skip empty lines
-    if (line[0] == '\n' || line[0] == '\0')
+  for (int i = 0; i < count; i++) {
+    // Lines without a light diagram aren't machines
+    if (batch.presses[i] == INT_MIN)
       continue;
 
-    Machine machine;
-    if (parse_machine(line, &machine)) {
-      int min_presses = machine_diagnostic(&machine);
+    if (batch.presses[i] < 0) {
+      fprintf(stderr, "Error: Memory allocation failed\n");
 
-      if (min_presses == INT_MAX) {
-        printf("Machine %d: No solution found!\n", machine_count + 1);
-      } else {
-        total_presses += min_presses;
-        machine_count++;
-      }
+      return 1;
+    }
+
+    if (batch.presses[i] == INT_MAX) {
+      result_printf(&results, "Machine %d: No solution found!\n",
+                    machine_count + 1);
+    } else {
+      total_presses += batch.presses[i];
+      machine_count++;
     }
   }
 
-  fclose(fp);
+  result_printf(&results, "Total number of machines diagnosed: %d\n",
+                machine_count);
+  result_printf(&results, "Fewest button presses required: %d\n",
+                total_presses);
+
+  arena_free(&batch.arena);
+  free(batch.presses);
 
-  printf("Total number of machines diagnosed: %d\n", machine_count);
-  printf("Fewest button presses required: %d\n", total_presses);
+  result_cache_finish(&results);
 
   return 0;
 }
 
-// Count number of set bits (popcount)
-int count_bits(unsigned int n) {
+void diagnose_task(void *ctx, int index) {
+  Batch *batch = ctx;
+  MachineView machine;
+
+  machine_view(&batch->arena, index, &machine);
+  batch->presses[index] = machine.num_lights < 0
+                              ? INT_MIN
+                              : machine_diagnostic(&machine);
+}
+
+// Bitset kernels, inlined into each solver below
+// Called with a constant width they unroll to straight-line code.
+#define BITSET_INLINE static inline __attribute__((always_inline))
+
+BITSET_INLINE void bits_xor(uint64_t *a, const uint64_t *b, int words) {
+  for (int k = 0; k < words; k++)
+    a[k] ^= b[k];
+}
+
+BITSET_INLINE int bits_count(const uint64_t *a, int words) {
   int count = 0;
 
-  while (n) {
-    count += n & 1;
-    n >>= 1;
-  }
+  for (int k = 0; k < words; k++)
+    count += __builtin_popcountll(a[k]);
 
   return count;
 }
 
-// Parser for the machines/lines
-int parse_machine(const char *line, Machine *machine) {
-  const char *p = line;
+// Highest set bit, or -1 for an empty set
+BITSET_INLINE int bits_top(const uint64_t *a, int words) {
+  for (int k = words - 1; k >= 0; k--)
+    if (a[k])
+      return k * 64 + 63 - __builtin_clzll(a[k]);
 
-  // Skip to '[' and parse target pattern
-  while (*p && *p != '[')
-    p++;
+  return -1;
+}
 
-  if (*p != '[')
-    return 0;
-  p++;
+BITSET_INLINE int bits_equal(const uint64_t *a, const uint64_t *b,
+                             int words) {
+  uint64_t diff = 0;
 
-  machine->num_lights = 0;
-  machine->target = 0;
+  for (int k = 0; k < words; k++)
+    diff |= a[k] ^ b[k];
 
-  while (*p && *p != ']') {
-    if (*p == '#')
-      machine->target |= (1 << machine->num_lights);
+  return diff == 0;
+}
 
-    machine->num_lights++;
-    p++;
-  }
+BITSET_INLINE uint64_t bits_hash(const uint64_t *a, int words) {
+  uint64_t hash = 0;
 
-  if (*p != ']')
-    return 0;
-  p++;
+  for (int k = 0; k < words; k++)
+    hash = (hash ^ a[k]) * 0x9E3779B97F4A7C15ULL;
 
-  // Parse buttons
-  machine->num_buttons = 0;
+  return hash;
+}
 
-  while (*p) {
-    // Find next '('
-    while (*p && *p != '(' && *p != '{')
-      p++;
+// Fewest set bits in solution XOR any combination of the kernel vectors
+// Combinations are visited in Gray-code order, so each step is one XOR.
+BITSET_INLINE int min_weight_gray(uint64_t *solution, const uint64_t *kernel,
+                                  int nullity, int words) {
+  uint64_t steps = nullity < 64 ? ((uint64_t)1 << nullity) - 1 : UINT64_MAX;
+  int best = bits_count(solution, words);
 
-    if (*p == '{')
-      break; // Reached joltage section
+  for (uint64_t i = 1; i <= steps && best > 0; i++) {
+    bits_xor(solution, kernel + __builtin_ctzll(i) * words, words);
 
-    if (*p != '(')
+    int presses = bits_count(solution, words);
+    if (presses < best)
+      best = presses;
+
+    if (i == UINT64_MAX)
       break;
-    p++;
+  }
+
+  return best;
+}
+
+// Fewest presses among start XOR each set of size rows of gen, or best if
+// none is lower; stops early once best reaches bound
+BITSET_INLINE int min_weight_subsets(const uint64_t *start,
+                                     const uint64_t *gen, int rows, int size,
+                                     uint64_t *sums, int *next, int best,
+                                     int bound, int words) {
+  size_t w = words;
+  int depth = 0;
+
+  memcpy(sums, start, w * sizeof(uint64_t));
+  next[0] = 0;
+
+  while (depth >= 0 && best > bound) {
+    int row = next[depth];
+
+    // Too few rows left to fill the set
+    if (row > rows - (size - depth)) {
+      depth--;
+      continue;
+    }
+
+    uint64_t *sum = sums + (depth + 1) * w;
+
+    next[depth] = row + 1;
+    memcpy(sum, sums + depth * w, w * sizeof(uint64_t));
+    bits_xor(sum, gen + row * w, words);
+
+    if (depth + 1 < size) {
+      next[++depth] = row + 1;
+    } else {
+      int presses = bits_count(sum, words);
+
+      if (presses < best)
+        best = presses;
+    }
+  }
+
+  return best;
+}
+
+// Same, trying the combinations by size so it can stop early
+// The null space is reduced once per group of buttons, the groups disjoint,
+// each taking as pivots as many buttons not in an earlier group as it can.
+// A solution then presses a group's pivot for each of its pivot rows it
+// uses, so once every combination of up to k rows has been tried on a
+// group with r pivots, any solution not found yet presses more than
+// k - (nullity - r) of its buttons. Adding that up over the groups bounds
+// every solution left, and the search stops when the best reaches it
+// (Brouwer-Zimmermann). Returns -1 if memory runs out.
+BITSET_INLINE int min_weight_bounded(const uint64_t *solution,
+                                     const uint64_t *kernel, int nullity,
+                                     int buttons, int words) {
+  if (nullity == 0)
+    return bits_count(solution, words);
+
+  size_t w = words, d = nullity;
+  size_t max_groups = buttons - nullity + 1; // The first takes d buttons
+  uint64_t *bits =
+      malloc((max_groups * (d + 1) + d + 3) * w * sizeof(uint64_t));
+  int *ints = malloc((2 * d + 2 * max_groups) * sizeof(int));
+
+  if (!bits || !ints) {
+    free(bits);
+    free(ints);
+
+    return -1;
+  }
+
+  uint64_t *gens = bits;                        // Per group: d rows
+  uint64_t *starts = gens + max_groups * d * w; // Per group: the solution
+  uint64_t *sums = starts + max_groups * w;     // Running XOR per depth
+  uint64_t *used = sums + (d + 1) * w;          // Buttons in some group
+  uint64_t *swap = used + w;
+  int *pivot = ints;             // The button each row of a group stands for
+  int *next = pivot + d;         // Per depth: the next row to try
+  int *rank = next + d;          // Per group: its pivots
+  int *size = rank + max_groups; // Per group: the next size to try
+  int groups = 0;
+
+  memset(used, 0, w * sizeof(uint64_t));
 
-    // Parse button definition
-    unsigned int button = 0;
+  while ((size_t)groups < max_groups) {
+    uint64_t *gen = gens + groups * d * w;
+    size_t r = 0;
 
-    while (*p && *p != ')') {
-      if (*p >= '0' && *p <= '9') {
-        int light_idx = 0;
+    memcpy(gen, kernel, d * w * sizeof(uint64_t));
 
-        while (*p >= '0' && *p <= '9') {
-          light_idx = light_idx * 10 + (*p - '0');
+    for (int c = 0; c < buttons && r < d; c++) {
+      if (machine_bit(used, c))
+        continue;
 
-          p++;
-        }
-        button |= (1 << light_idx);
-      } else {
+      size_t p = r;
+
+      while (p < d && !machine_bit(gen + p * w, c))
         p++;
+
+      if (p == d)
+        continue;
+
+      memcpy(swap, gen + p * w, w * sizeof(uint64_t));
+      memcpy(gen + p * w, gen + r * w, w * sizeof(uint64_t));
+      memcpy(gen + r * w, swap, w * sizeof(uint64_t));
+
+      for (size_t i = 0; i < d; i++)
+        if (i != r && machine_bit(gen + i * w, c))
+          bits_xor(gen + i * w, gen + r * w, words);
+
+      pivot[r++] = c;
+    }
+
+    // Every button left is out of the null space's reach
+    if (r == 0)
+      break;
+
+    // Start from the solution pressing none of the group's pivots
+    uint64_t *start = starts + groups * w;
+
+    memcpy(start, solution, w * sizeof(uint64_t));
+
+    for (size_t i = 0; i < r; i++) {
+      used[pivot[i] / 64] |= (uint64_t)1 << (pivot[i] % 64);
+
+      if (machine_bit(start, pivot[i]))
+        bits_xor(start, gen + i * w, words);
+    }
+
+    rank[groups] = (int)r;
+    size[groups] = 1;
+    groups++;
+  }
+
+  // Size 0 on every group, which only the full ones count towards the bound
+  int best = INT_MAX, bound = 0;
+
+  for (int g = 0; g < groups; g++) {
+    int presses = bits_count(starts + g * w, words);
+
+    if (presses < best)
+      best = presses;
+
+    if (rank[g] == nullity)
+      bound++;
+  }
+
+  for (int k = 1; k <= nullity && best > bound; k++) {
+    for (int g = 0; g < groups && best > bound; g++) {
+      // A group adds to the bound once k covers the pivots it lacks
+      if (k < nullity - rank[g])
+        continue;
+
+      while (size[g] <= k && best > bound) {
+        best = min_weight_subsets(starts + g * w, gens + g * d * w, nullity,
+                                  size[g], sums, next, best, bound, words);
+
+        if (++size[g] > nullity - rank[g])
+          bound++;
       }
     }
+  }
+
+  free(bits);
+  free(ints);
+
+  return best;
+}
+
+// Meet-in-the-middle over the two halves of the buttons
+// Every subset of the first half goes into a table keyed by the lights it
+// toggles, then each subset of the second half looks up the lights still
+// needed. Returns -1 if the table can't be allocated.
+BITSET_INLINE int min_weight_mitm(const MachineView *machine, int words) {
+  int left = machine->num_buttons / 2;
+  int right = machine->num_buttons - left;
+  size_t size = (size_t)2 << left;
+  int shift = 64 - (left + 1);
+  const uint64_t *target = machine->target;
+  const uint64_t *buttons = machine->buttons;
+  uint64_t *keys = malloc(size * words * sizeof(uint64_t));
+  int *presses_at = malloc(size * sizeof(int)); // -1 when the slot is free
+  uint64_t *lights = malloc(2 * words * sizeof(uint64_t));
+
+  if (!keys || !presses_at || !lights) {
+    free(keys);
+    free(presses_at);
+    free(lights);
+
+    return -1;
+  }
+
+  uint64_t *needed = lights + words;
 
-    if (*p == ')') {
-      machine->buttons[machine->num_buttons++] = button;
+  for (size_t i = 0; i < size; i++)
+    presses_at[i] = -1;
 
-      p++;
+  // Subsets of the first half
+  memset(lights, 0, words * sizeof(uint64_t));
+
+  for (uint64_t i = 0; i < (uint64_t)1 << left; i++) {
+    if (i)
+      bits_xor(lights, buttons + __builtin_ctzll(i) * words, words);
+
+    int presses = __builtin_popcountll(i ^ (i >> 1));
+    size_t slot = bits_hash(lights, words) >> shift;
+
+    while (presses_at[slot] >= 0 &&
+           !bits_equal(keys + slot * words, lights, words))
+      slot = (slot + 1) & (size - 1);
+
+    if (presses_at[slot] < 0 || presses < presses_at[slot]) {
+      memcpy(keys + slot * words, lights, words * sizeof(uint64_t));
+      presses_at[slot] = presses;
     }
   }
 
-  return 1;
+  // Subsets of the second half, matched against the lights left over
+  int best = INT_MAX;
+  memset(lights, 0, words * sizeof(uint64_t));
+
+  for (uint64_t i = 0; i < (uint64_t)1 << right; i++) {
+    if (i)
+      bits_xor(lights, buttons + (left + __builtin_ctzll(i)) * words, words);
+
+    int presses = __builtin_popcountll(i ^ (i >> 1));
+
+    memcpy(needed, target, words * sizeof(uint64_t));
+    bits_xor(needed, lights, words);
+
+    size_t slot = bits_hash(needed, words) >> shift;
+
+    while (presses_at[slot] >= 0 &&
+           !bits_equal(keys + slot * words, needed, words))
+      slot = (slot + 1) & (size - 1);
+
+    if (presses_at[slot] >= 0 && presses_at[slot] + presses < best)
+      best = presses_at[slot] + presses;
+  }
+
+  free(keys);
+  free(presses_at);
+  free(lights);
+
+  return best;
 }
 
-// Find least amount of button presses to activate a machine
-int machine_diagnostic(Machine *machine) {
-  int min_presses = INT_MAX;
+// Memory min_weight_mitm() needs for a machine with this many buttons
+BITSET_INLINE size_t mitm_table_bytes(int buttons, int words) {
+  size_t slot = words * sizeof(uint64_t) + sizeof(int);
 
-  // Brute force all 2^num_buttons combinations
-  unsigned int total_combinations = 1U << machine->num_buttons;
+  return ((size_t)2 << (buttons / 2)) * slot;
+}
+
+BITSET_INLINE int log2_ceil(int n) {
+  int bits = 0;
 
-  for (unsigned int combo_special = 0; combo_special < total_combinations;
-       combo_special++) {
-    unsigned int state = 0; // Init all lights off
+  while ((1 << bits) < n)
+    bits++;
+
+  return bits;
+}
 
-    // Apply each button press in the special combination
-    for (int i = 0; i < machine->num_buttons; i++) {
-      if (combo_special & (1U << i))
-        // XOR toggle
-        state ^= machine->buttons[i];
+// Shortest sequence of presses, breadth-first over the reachable patterns
+// Each pattern is written in the echelon basis from elimination, so there
+// are exactly 2^rank of them. Suits many buttons over few lights, where the
+// null space is huge. Returns -1 if memory runs out.
+BITSET_INLINE int min_presses_bfs(const MachineView *machine,
+                                  const uint64_t *pivot_row, int rank,
+                                  int words) {
+  int lights = machine->num_lights, buttons = machine->num_buttons;
+  size_t w = words;
+  size_t states = (size_t)1 << rank;
+  int *basis_index = malloc(lights * sizeof(int));
+  uint32_t *moves = malloc((buttons + 1) * sizeof(uint32_t));
+  uint32_t *queue = malloc(states * sizeof(uint32_t));
+  unsigned char *dist = malloc(states);
+  uint64_t *row = malloc(w * sizeof(uint64_t));
+
+  if (!basis_index || !moves || !queue || !dist || !row) {
+    free(basis_index);
+    free(moves);
+    free(queue);
+    free(dist);
+    free(row);
+
+    return -1;
+  }
+
+  // Number the pivots, then write the target and each button in that basis
+  int next = 0;
+
+  for (int light = 0; light < lights; light++)
+    basis_index[light] =
+        bits_top(pivot_row + light * w, words) >= 0 ? next++ : -1;
+
+  for (int b = 0; b <= buttons; b++) {
+    const uint64_t *pattern =
+        b < buttons ? machine->buttons + b * w : machine->target;
+    uint32_t coords = 0;
+    int pivot;
+
+    memcpy(row, pattern, w * sizeof(uint64_t));
+
+    while ((pivot = bits_top(row, words)) >= 0) {
+      bits_xor(row, pivot_row + pivot * w, words);
+      coords |= (uint32_t)1 << basis_index[pivot];
     }
-    // Check if target reached
-    if (state == machine->target) {
-      int presses = count_bits(combo_special);
 
-      if (presses < min_presses)
-        min_presses = presses;
+    moves[b] = coords;
+  }
+
+  uint32_t goal = moves[buttons];
+  int best = INT_MAX;
+  size_t head = 0, tail = 0;
+
+  memset(dist, 0xff, states);
+  dist[0] = 0;
+  queue[tail++] = 0;
+
+  while (head < tail) {
+    uint32_t state = queue[head++];
+
+    if (state == goal) {
+      best = dist[state];
+      break;
+    }
+
+    for (int b = 0; b < buttons; b++) {
+      uint32_t to = state ^ moves[b];
+
+      if (dist[to] == 0xff) {
+        dist[to] = dist[state] + 1;
+        queue[tail++] = to;
+      }
+    }
+  }
+
+  free(basis_index);
+  free(moves);
+  free(queue);
+  free(dist);
+  free(row);
+
+  return best;
+}
+
+// Find least amount of button presses to activate a machine
+// Pressing a button twice undoes it, so this is a linear system over GF(2):
+// the buttons' light patterns are columns and the target the right-hand side.
+// Elimination gives one solution and a basis of the null space (button sets
+// that change nothing); every solution is the first XORed with some
+// combination of the basis, so only those 2^nullity candidates are searched.
+// Returns INT_MAX if the target can't be reached, -1 if memory runs out.
+BITSET_INLINE int diagnose(const MachineView *machine, int words) {
+  int lights = machine->num_lights, buttons = machine->num_buttons;
+  size_t w = words;
+
+  // Per light: the reduced row with that light as its top bit, and the
+  // buttons XORed together to make it. Then the null space, and room for
+  // one row, its combination and the solution.
+  uint64_t *scratch =
+      calloc((2 * lights + buttons + 3) * w, sizeof(uint64_t));
+  if (!scratch)
+    return -1;
+
+  uint64_t *pivot_row = scratch;
+  uint64_t *pivot_combo = pivot_row + lights * w;
+  uint64_t *kernel = pivot_combo + lights * w;
+  uint64_t *row = kernel + buttons * w;
+  uint64_t *combo = row + w;
+  uint64_t *solution = combo + w;
+  int nullity = 0;
+
+  for (int b = 0; b < buttons; b++) {
+    memcpy(row, machine->buttons + b * w, w * sizeof(uint64_t));
+    memset(combo, 0, w * sizeof(uint64_t));
+    combo[b / 64] = (uint64_t)1 << (b % 64);
+
+    int pivot;
+
+    while ((pivot = bits_top(row, words)) >= 0) {
+      uint64_t *basis = pivot_row + pivot * w;
+
+      if (bits_top(basis, words) < 0) {
+        memcpy(basis, row, w * sizeof(uint64_t));
+        memcpy(pivot_combo + pivot * w, combo, w * sizeof(uint64_t));
+        break;
+      }
+
+      bits_xor(row, basis, words);
+      bits_xor(combo, pivot_combo + pivot * w, words);
     }
+
+    // Reduced to nothing: these buttons cancel out
+    if (pivot < 0)
+      memcpy(kernel + nullity++ * w, combo, w * sizeof(uint64_t));
+  }
+
+  // One solution, if the target is reachable at all
+  memcpy(row, machine->target, w * sizeof(uint64_t));
+
+  int pivot;
+
+  while ((pivot = bits_top(row, words)) >= 0) {
+    uint64_t *basis = pivot_row + pivot * w;
+
+    if (bits_top(basis, words) < 0) {
+      free(scratch);
+
+      return INT_MAX;
+    }
+
+    bits_xor(row, basis, words);
+    bits_xor(solution, pivot_combo + pivot * w, words);
   }
 
-  return min_presses;
+  // Pick the cheapest search: the null space, the two button halves, or
+  // every reachable light pattern. A null space too big to walk in full is
+  // searched by weight.
+  int rank = buttons - nullity;
+  int half = (buttons + 1) / 2;
+  double gray_cost = (double)nullity;
+  int mitm_fits = half <= MITM_MAX_HALF &&
+                  mitm_table_bytes(buttons, words) <= mitm_budget;
+  double mitm_cost = mitm_fits ? half + 1.0 : 1e9;
+  double bfs_cost = rank <= BFS_MAX_RANK ? rank + log2_ceil(buttons) : 1e9;
+  int presses = -1;
+
+  if (bfs_cost < gray_cost && bfs_cost <= mitm_cost)
+    presses = min_presses_bfs(machine, pivot_row, rank, words);
+  else if (mitm_cost < gray_cost)
+    presses = min_weight_mitm(machine, words);
+
+  if (presses < 0 && nullity <= GRAY_MAX_NULLITY)
+    presses = min_weight_gray(solution, kernel, nullity, words);
+  else if (presses < 0)
+    presses = min_weight_bounded(solution, kernel, nullity, buttons, words);
+
+  free(scratch);
+
+  return presses;
+}
+
+// One solver per common width, plus one for any width
+#define DEFINE_DIAGNOSE(WORDS)                                                 \
+  int diagnose_##WORDS(const MachineView *machine) {                           \
+    return diagnose(machine, WORDS);                                           \
+  }
+
+DEFINE_DIAGNOSE(1)
+DEFINE_DIAGNOSE(2)
+DEFINE_DIAGNOSE(4)
+
+int diagnose_any(const MachineView *machine) {
+  return diagnose(machine, machine->words);
+}
+
+int machine_diagnostic(const MachineView *machine) {
+  switch (machine->words) {
+  case 1:
+    return diagnose_1(machine);
+  case 2:
+    return diagnose_2(machine);
+  case 4:
+    return diagnose_4(machine);
+  default:
+    return diagnose_any(machine);
+  }
 }
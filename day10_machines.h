@@ -0,0 +1,359 @@
+/*
+ * Routine: Advent of Code--Day 10: Machine Records
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * One parser for both parts of day 10. Every non-empty input line becomes a
+ * compact binary record in a single arena: a small header, the light diagram
+ * and each button as bitsets of 64-bit words, then the joltage targets.
+ * Lines can be any length, since they're parsed straight from the mapped
+ * file.
+ *
+ * With AOC_INPUT_CACHE set, the arena is kept in the input cache (see
+ * input_cache.h), so later runs on the same input work straight from the
+ * cache file and skip the text entirely.
+ *
+ * Needs _POSIX_C_SOURCE 200809L.
+ */
+
+#ifndef DAY10_MACHINES_H
+#define DAY10_MACHINES_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "input_cache.h"
+
+#define DAY10_INPUT_KIND INPUT_CACHE_KIND(10, 1) // Bump the version on change
+
+// Start of every record
+// num_lights counts the diagram plus any light a button names beyond it, and
+// is -1 when the line has no diagram; num_counters is -1 without a joltage
+// section. Bitsets are `words` long, wide enough for every light and counter
+// index and for one bit per button.
+typedef struct {
+  int32_t num_lights;
+  int32_t num_buttons;
+  int32_t num_counters;
+  int32_t words;
+} MachineHeader;
+
+// A record in the arena, as read back
+typedef struct {
+  int num_lights, num_buttons, num_counters, words;
+  const uint64_t *target;  // Light diagram
+  const uint64_t *buttons; // words per button
+  const int32_t *counters; // Joltage targets
+} MachineView;
+
+typedef struct {
+  unsigned char *data; // Records, each starting on an 8-byte boundary
+  size_t used, capacity;
+  uint64_t *offsets; // Byte offset of each record
+  int count, offsets_capacity;
+  InputCache input; // Holds data and offsets when they're cached
+} MachineArena;
+
+static inline int machine_bit(const uint64_t *bits, int i) {
+  return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+static inline void machine_view(const MachineArena *arena, int i,
+                                MachineView *view) {
+  const unsigned char *record = arena->data + arena->offsets[i];
+  const MachineHeader *header = (const MachineHeader *)record;
+  int buttons = header->num_buttons;
+
+  view->num_lights = header->num_lights;
+  view->num_buttons = buttons;
+  view->num_counters = header->num_counters;
+  view->words = header->words;
+  view->target = (const uint64_t *)(record + sizeof(MachineHeader));
+  view->buttons = view->target + header->words;
+  view->counters =
+      (const int32_t *)(view->buttons + (size_t)buttons * header->words);
+}
+
+static inline void arena_free(MachineArena *arena) {
+  if (!input_cache_hit(&arena->input)) {
+    free(arena->data);
+    free(arena->offsets);
+  }
+
+  input_cache_close(&arena->input);
+  arena->data = NULL;
+  arena->offsets = NULL;
+}
+
+// Reserve room for one more record of bytes, return its start or NULL
+static inline unsigned char *arena_reserve(MachineArena *arena, size_t bytes) {
+  if (arena->count == arena->offsets_capacity) {
+    int capacity = arena->offsets_capacity ? arena->offsets_capacity * 2 : 256;
+    uint64_t *grown = realloc(arena->offsets, capacity * sizeof(uint64_t));
+
+    if (!grown)
+      return NULL;
+    arena->offsets = grown;
+    arena->offsets_capacity = capacity;
+  }
+
+  if (arena->used + bytes > arena->capacity) {
+    size_t capacity = arena->capacity ? arena->capacity * 2 : 65536;
+
+    while (capacity < arena->used + bytes)
+      capacity *= 2;
+
+    unsigned char *grown = realloc(arena->data, capacity);
+    if (!grown)
+      return NULL;
+    arena->data = grown;
+    arena->capacity = capacity;
+  }
+
+  unsigned char *record = arena->data + arena->used;
+
+  memset(record, 0, bytes);
+  arena->offsets[arena->count++] = arena->used;
+  arena->used += bytes;
+
+  return record;
+}
+
+// Bytes a record takes, header included
+static inline uint64_t machine_record_bytes(int num_buttons, int num_counters,
+                                            int words) {
+  uint64_t counters = num_counters > 0 ? num_counters : 0;
+
+  return sizeof(MachineHeader) +
+         ((uint64_t)num_buttons + 1) * words * sizeof(uint64_t) +
+         (counters * sizeof(int32_t) + 7) / 8 * 8;
+}
+
+static inline int parse_number(const char **p, const char *end) {
+  int value = 0;
+
+  while (*p < end && **p >= '0' && **p <= '9') {
+    if (value <= (INT32_MAX - 9) / 10)
+      value = value * 10 + (**p - '0');
+    (*p)++;
+  }
+
+  return value;
+}
+
+// Append the record for the line [line, end)
+// A first pass sizes the record, the second fills it in. Returns 0 if memory
+// runs out.
+static inline int parse_machine_record(MachineArena *arena, const char *line,
+                                       const char *end) {
+  const char *p = line;
+  const char *diagram = NULL;
+  int diagram_lights = 0, num_lights = -1;
+
+  // Light diagram [...]
+  while (p < end && *p != '[')
+    p++;
+
+  if (p < end && *p == '[') {
+    diagram = ++p;
+
+    while (p < end && *p != ']')
+      p++;
+
+    if (p < end && *p == ']') {
+      diagram_lights = num_lights = (int)(p - diagram);
+      p++;
+    } else {
+      diagram = NULL;
+    }
+  }
+
+  // Count the buttons and the highest light they name
+  const char *button_list = p;
+  int num_buttons = 0, highest = -1, inside = 0;
+
+  for (; diagram && p < end && *p != '{'; p++) {
+    if (*p == '(') {
+      num_buttons++;
+      inside = 1;
+    } else if (*p == ')') {
+      inside = 0;
+    } else if (inside && *p >= '0' && *p <= '9') {
+      int idx = parse_number(&p, end);
+
+      p--;
+      if (idx > highest)
+        highest = idx;
+    }
+  }
+
+  // Count the joltage targets {...}
+  const char *joltage = NULL;
+  int num_counters = -1;
+
+  if (diagram && p < end && *p == '{') {
+    joltage = ++p;
+    num_counters = 0;
+
+    for (; p < end && *p != '}'; p++) {
+      if (*p >= '0' && *p <= '9') {
+        parse_number(&p, end);
+        p--;
+        num_counters++;
+      }
+    }
+  }
+
+  if (highest >= num_lights && diagram)
+    num_lights = highest + 1;
+
+  // Wide enough for every index and one bit per button, rounded up to a
+  // width with its own kernels
+  int needed = num_lights;
+  if (num_buttons > needed)
+    needed = num_buttons;
+  if (num_counters > needed)
+    needed = num_counters;
+
+  int words = (needed + 63) / 64;
+  if (words == 0)
+    words = 1;
+  else if (words == 3)
+    words = 4;
+
+  unsigned char *record = arena_reserve(
+      arena, machine_record_bytes(num_buttons, num_counters, words));
+  if (!record)
+    return 0;
+
+  MachineHeader *header = (MachineHeader *)record;
+  header->num_lights = num_lights;
+  header->num_buttons = num_buttons;
+  header->num_counters = num_counters;
+  header->words = words;
+
+  uint64_t *target = (uint64_t *)(record + sizeof(MachineHeader));
+  uint64_t *button = target + words;
+  int32_t *counter = (int32_t *)(button + (size_t)num_buttons * words);
+
+  for (int i = 0; i < diagram_lights; i++)
+    if (diagram[i] == '#')
+      target[i / 64] |= (uint64_t)1 << (i % 64);
+
+  // Buttons (...)
+  uint64_t *next_button = button;
+  inside = 0;
+
+  for (p = button_list; diagram && p < end && *p != '{'; p++) {
+    if (*p == '(') {
+      button = next_button;
+      next_button += words;
+      inside = 1;
+    } else if (*p == ')') {
+      inside = 0;
+    } else if (inside && *p >= '0' && *p <= '9') {
+      int idx = parse_number(&p, end);
+
+      p--;
+      button[idx / 64] |= (uint64_t)1 << (idx % 64);
+    }
+  }
+
+  for (p = joltage; joltage && p < end && *p != '}'; p++) {
+    if (*p >= '0' && *p <= '9') {
+      *counter++ = parse_number(&p, end);
+      p--;
+    }
+  }
+
+  return 1;
+}
+
+// Point the arena at its cached records, return 0 if they don't fit
+static inline int load_cached_machines(MachineArena *arena) {
+  size_t offsets_size, data_size;
+  const uint64_t *offsets =
+      input_cache_section(&arena->input, 0, &offsets_size);
+  const unsigned char *data = input_cache_section(&arena->input, 1, &data_size);
+  size_t count = offsets_size / sizeof(uint64_t);
+
+  if (!offsets || !data || count > INT32_MAX)
+    return 0;
+
+  // Every record must hold its header and the bitsets it says it has
+  for (size_t i = 0; i < count; i++) {
+    if (offsets[i] % 8 != 0 || offsets[i] > data_size ||
+        data_size - offsets[i] < sizeof(MachineHeader))
+      return 0;
+
+    const MachineHeader *header = (const MachineHeader *)(data + offsets[i]);
+
+    if (header->num_buttons < 0 || header->words < 1 ||
+        machine_record_bytes(header->num_buttons, header->num_counters,
+                             header->words) > data_size - offsets[i])
+      return 0;
+  }
+
+  // Read only: nothing appends to a loaded arena
+  arena->offsets = (uint64_t *)offsets;
+  arena->data = (unsigned char *)data;
+  arena->count = arena->offsets_capacity = (int)count;
+  arena->used = arena->capacity = data_size;
+
+  return 1;
+}
+
+// Parse every machine in the file into the arena, or load it from the cache
+// Returns 0 on failure, after reporting it.
+static inline int load_machines(MachineArena *arena, const char *filename) {
+  MachineArena empty = {NULL, 0, 0, NULL, 0, 0, {0}};
+  *arena = empty;
+
+  if (!input_cache_open(&arena->input, filename, DAY10_INPUT_KIND, 0)) {
+    perror("Error opening file");
+
+    return 0;
+  }
+
+  if (input_cache_hit(&arena->input)) {
+    if (load_cached_machines(arena))
+      return 1;
+
+    input_cache_reject(&arena->input);
+  }
+
+  // Parse the mapped text where it lies
+  const char *text = arena->input.text;
+  size_t size = arena->input.size;
+
+  for (size_t start = 0; start < size;) {
+    const char *line = text + start;
+    const char *end = memchr(line, '\n', size - start);
+    if (!end)
+      end = text + size;
+
+    // Skip empty lines
+    if (line < end && line[0] != '\r' &&
+        !parse_machine_record(arena, line, end)) {
+      fprintf(stderr, "Error: Memory allocation failed\n");
+      arena_free(arena);
+
+      return 0;
+    }
+
+    start = (size_t)(end - text) + 1;
+  }
+
+  const void *sections[] = {arena->offsets, arena->data};
+  size_t sizes[] = {arena->count * sizeof(uint64_t), arena->used};
+
+  input_cache_store(&arena->input, 2, sections, sizes);
+
+  return 1;
+}
+
+#endif
@@ -5,277 +5,369 @@
  *
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  *
- * Solution using COIN-OR Branch and Cut (Cbc) Integer Linear Programming
+ * Solution using exact integer Gaussian elimination, then a branch and bound
+ * over the few free variables left
  *
- * To compile: gcc -std=c99 -O2 day10_part2.c $(pkg-config --cflags --libs cbc)
- * -o day10_part2
+ * To compile: gcc -std=c99 -O2 day10_part2.c -pthread -o day10_part2
  */
 
-#include <Cbc_C_Interface.h>
+#define _POSIX_C_SOURCE 200809L
+
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "day10_machines.h"
+#include "result_cache.h"
+#include "work_pool.h"
+
 #define MAX_COUNTERS 16
 #define MAX_BUTTONS 32
-#define MAX_LINE 1024
+#define DAY10_RESULT_VERSION 1
 
+// The press equations in reduced row echelon form, over the integers
+// Row r reads: pivot_coef[r] * x[pivot_col[r]] + sum over free buttons f of
+// coef[r][f] * x[free_col[f]] = rhs[r]. Pivot coefficients are positive.
+typedef struct {
+  int rank;
+  int pivot_col[MAX_COUNTERS];
+  long long pivot_coef[MAX_COUNTERS];
+  int num_free;
+  int free_col[MAX_BUTTONS];
+  long long coef[MAX_COUNTERS][MAX_BUTTONS];
+  long long rhs[MAX_COUNTERS];
+  int upper[MAX_BUTTONS]; // Most presses of each free button
+  double weight[MAX_BUTTONS]; // Change in total presses per free press
+} ReducedSystem;
+
+// Branch and bound state
+// low_sum/high_sum[f][r] bound what free buttons f.. can still take off row
+// r's right-hand side, and bound_sum[f] the most they can lower the total.
+typedef struct {
+  const ReducedSystem *sys;
+  long long residual[MAX_COUNTERS];
+  long long low_sum[MAX_BUTTONS + 1][MAX_COUNTERS];
+  long long high_sum[MAX_BUTTONS + 1][MAX_COUNTERS];
+  double bound_sum[MAX_BUTTONS + 1];
+  int presses; // Free presses so far
+  int best;
+} Search;
+
+// Every machine in the input, and its fewest presses
+// INT_MIN marks a line that isn't a machine this solver can take.
 typedef struct {
-  int num_counters;
-  int targets[MAX_COUNTERS];
-  int num_buttons;
-  int button_effects[MAX_BUTTONS][MAX_COUNTERS];
-} Machine;
+  MachineArena arena;
+  int *presses;
+} Batch;
 
 // Prototypes
-int parse_machine_part2(const char *line, Machine *machine);
-int solve_machine_ilp(const Machine *machine, int machine_id);
+void solve_task(void *ctx, int index);
+int solve_machine(const MachineView *machine);
+int reduce_system(const MachineView *machine, ReducedSystem *sys);
+void search_free(Search *search, int f);
+long long gcd_ll(long long a, long long b);
 
 int main(void) {
-  FILE *fp = fopen("day10_input.txt", "r");
-  if (!fp) {
-    perror("Error opening file");
+  ResultCache results;
+  if (result_cache_open(&results, "day10_input.txt", 10, 2,
+                        DAY10_RESULT_VERSION, 0, NULL))
+    return 0;
+
+  result_printf(&results,
+                "Processing: Integer elimination with branch and bound...\n\n");
+
+  // Parse the whole batch up front
+  Batch batch;
+  if (!load_machines(&batch.arena, "day10_input.txt"))
+    return 1;
+
+  int count = batch.arena.count;
+  batch.presses = malloc((count ? count : 1) * sizeof(int));
+  if (!batch.presses) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
 
     return 1;
   }
 
-  // Init main variables
-  char line[MAX_LINE];
+  // Machines are independent, so solve them across all cores
+  pool_run(count, solve_task, &batch);
+
+  // Tally in input order
   int total_presses = 0;
   int machine_count = 0;
   int solved_count = 0;
 
-  printf("Processing: Cbc Library--Integer Linear Programming...\n\n");
-
-  while (fgets(line, sizeof(line), fp)) {
-    if (line[0] == '\n' || line[0] == '\0')
-      continue;
-
+  for (int i = 0; i < count; i++) {
     machine_count++;
-    Machine machine;
 
-    if (!parse_machine_part2(line, &machine)) {
-      printf("Machine %d: Failed to parse\n", machine_count);
+    if (batch.presses[i] == INT_MIN) {
+      result_printf(&results, "Machine %d: Failed to parse\n", machine_count);
       continue;
     }
 
-    int result = solve_machine_ilp(&machine, machine_count);
+    int result = batch.presses[i];
 
     if (result >= 0) {
       total_presses += result;
       solved_count++;
       if (machine_count <= 10) {
-        printf("Machine %d: %d presses ✓\n", machine_count, result);
+        result_printf(&results, "Machine %d: %d presses ✓\n", machine_count,
+                      result);
       }
     } else {
-      printf("Machine %d: No solution found ✗\n", machine_count);
+      result_printf(&results, "Machine %d: No solution found ✗\n",
+                    machine_count);
     }
   }
 
-  fclose(fp);
+  result_printf(&results, "\n");
+  result_printf(&results,
+                "==================================================\n");
+  result_printf(&results, "Total machines: %d\n", machine_count);
+  result_printf(&results, "Solved: %d\n", solved_count);
+  result_printf(&results, "Failed: %d\n", machine_count - solved_count);
+  result_printf(&results, "Fewest button presses required: %d\n",
+                total_presses);
+  result_printf(&results,
+                "==================================================\n");
+
+  arena_free(&batch.arena);
+  free(batch.presses);
 
-  printf("\n");
-  printf("==================================================\n");
-  printf("Total machines: %d\n", machine_count);
-  printf("Solved: %d\n", solved_count);
-  printf("Failed: %d\n", machine_count - solved_count);
-  printf("Fewest button presses required: %d\n", total_presses);
-  printf("==================================================\n");
+  result_cache_finish(&results);
 
   return 0;
 }
 
-int parse_machine_part2(const char *line, Machine *machine) {
-  const char *p = line;
+void solve_task(void *ctx, int index) {
+  Batch *batch = ctx;
+  MachineView machine;
 
-  // Skip indicator lights section [...]
-  while (*p && *p != '[')
-    p++;
+  machine_view(&batch->arena, index, &machine);
 
-  if (*p != '[')
-    return 0;
+  // Needs both sections, and the equations must fit the fixed-size system
+  if (machine.num_lights < 0 || machine.num_counters < 0 ||
+      machine.num_counters > MAX_COUNTERS ||
+      machine.num_buttons > MAX_BUTTONS)
+    batch->presses[index] = INT_MIN;
+  else
+    batch->presses[index] = solve_machine(&machine);
+}
 
-  while (*p && *p != ']')
-    p++;
+// Fewest presses meeting every joltage target, or -1 if there is no way
+// Elimination leaves each pivot button as a function of the free ones, so
+// only the free buttons are searched, each between 0 and the smallest target
+// it feeds.
+int solve_machine(const MachineView *machine) {
+  ReducedSystem sys;
+
+  if (!reduce_system(machine, &sys))
+    return -1;
+
+  Search search;
+  search.sys = &sys;
+  search.presses = 0;
+  search.best = INT_MAX;
+
+  for (int r = 0; r < sys.rank; r++) {
+    search.residual[r] = sys.rhs[r];
+    search.low_sum[sys.num_free][r] = 0;
+    search.high_sum[sys.num_free][r] = 0;
+  }
+  search.bound_sum[sys.num_free] = 0;
 
-  if (*p != ']')
-    return 0;
-  p++;
+  for (int f = sys.num_free - 1; f >= 0; f--) {
+    for (int r = 0; r < sys.rank; r++) {
+      long long most = sys.coef[r][f] * sys.upper[f];
 
-  // Init
-  machine->num_buttons = 0;
-  for (int i = 0; i < MAX_BUTTONS; i++) {
-    for (int j = 0; j < MAX_COUNTERS; j++) {
-      machine->button_effects[i][j] = 0;
+      search.low_sum[f][r] = search.low_sum[f + 1][r] + (most < 0 ? most : 0);
+      search.high_sum[f][r] =
+          search.high_sum[f + 1][r] + (most > 0 ? most : 0);
     }
-  }
 
-  // Parse buttons
-  int button_idx = 0;
-  while (*p && *p != '{') {
-    while (*p && *p != '(' && *p != '{')
-      p++;
+    double most = sys.weight[f] * sys.upper[f];
+    search.bound_sum[f] = search.bound_sum[f + 1] + (most < 0 ? most : 0);
+  }
 
-    if (*p == '{')
-      break;
+  search_free(&search, 0);
 
-    if (*p != '(')
-      break;
-    p++;
+  return search.best == INT_MAX ? -1 : search.best;
+}
 
-    while (*p && *p != ')') {
-      if (*p >= '0' && *p <= '9') {
-        int counter_idx = 0;
+// Bring the equations to reduced row echelon form without fractions
+// Rows are combined by cross-multiplying and then divided by their gcd, so
+// every value stays an exact, small integer. Returns 0 if the equations
+// contradict each other.
+int reduce_system(const MachineView *machine, ReducedSystem *sys) {
+  int rows = machine->num_counters, cols = machine->num_buttons;
+  long long m[MAX_COUNTERS][MAX_BUTTONS + 1];
+  int is_pivot[MAX_BUTTONS] = {0};
+
+  for (int c = 0; c < rows; c++) {
+    for (int b = 0; b < cols; b++)
+      m[c][b] = machine_bit(machine->buttons + b * machine->words, c);
+    m[c][cols] = machine->counters[c];
+  }
 
-        while (*p >= '0' && *p <= '9') {
-          counter_idx = counter_idx * 10 + (*p - '0');
+  int rank = 0;
 
-          p++;
-        }
-        machine->button_effects[button_idx][counter_idx] = 1;
-      } else {
-        p++;
-      }
-    }
+  for (int col = 0; col < cols && rank < rows; col++) {
+    int pick = -1;
 
-    if (*p == ')') {
-      button_idx++;
-      p++;
-    }
-  }
-  machine->num_buttons = button_idx;
+    for (int r = rank; r < rows; r++)
+      if (m[r][col] != 0 &&
+          (pick < 0 || llabs(m[r][col]) < llabs(m[pick][col])))
+        pick = r;
 
-  // Parse joltage requirements
-  while (*p && *p != '{')
-    p++;
+    if (pick < 0)
+      continue;
 
-  if (*p != '{')
-    return 0;
-  p++;
+    for (int k = 0; k <= cols; k++) {
+      long long tmp = m[rank][k];
+      m[rank][k] = m[pick][k];
+      m[pick][k] = tmp;
+    }
 
-  int target_idx = 0;
+    if (m[rank][col] < 0)
+      for (int k = 0; k <= cols; k++)
+        m[rank][k] = -m[rank][k];
 
-  while (*p && *p != '}') {
-    if (*p >= '0' && *p <= '9') {
-      int value = 0;
+    // Clear the column from every other row
+    for (int r = 0; r < rows; r++) {
+      if (r == rank || m[r][col] == 0)
+        continue;
 
-      while (*p >= '0' && *p <= '9') {
-        value = value * 10 + (*p - '0');
+      long long a = m[rank][col], b = m[r][col];
+      long long g = 0;
 
-        p++;
+      for (int k = 0; k <= cols; k++) {
+        m[r][k] = m[r][k] * a - m[rank][k] * b;
+        g = gcd_ll(g, m[r][k]);
       }
-      machine->targets[target_idx++] = value;
-    } else {
-      p++;
+
+      if (g > 1)
+        for (int k = 0; k <= cols; k++)
+          m[r][k] /= g;
     }
+
+    sys->pivot_col[rank] = col;
+    is_pivot[col] = 1;
+    rank++;
   }
 
-  machine->num_counters = target_idx;
+  // Leftover rows read 0 = rhs
+  for (int r = rank; r < rows; r++)
+    if (m[r][cols] != 0)
+      return 0;
 
-  return 1;
-}
+  sys->rank = rank;
+  sys->num_free = 0;
 
-int solve_machine_ilp(const Machine *machine, int machine_id) {
-  Cbc_Model *model = Cbc_newModel();
+  for (int b = 0; b < cols; b++)
+    if (!is_pivot[b])
+      sys->free_col[sys->num_free++] = b;
 
-  // Suppress output
-  Cbc_setLogLevel(model, 0);
+  for (int r = 0; r < rank; r++) {
+    long long g = 0;
 
-  // Add columns (variables): one for each button
-  // Variables are non-negative integers (number of button presses)
-  for (int b = 0; b < machine->num_buttons; b++) {
-    char var_name[32];
-    snprintf(var_name, sizeof(var_name), "button_%d", b);
+    for (int k = 0; k <= cols; k++)
+      g = gcd_ll(g, m[r][k]);
 
-    // Parameters: name, lower_bound, upper_bound, objective_coef, isInteger,
-    // nz, rows, coefs
-    // Minimise button presses, objective coefficient is 1
-    // Add constraints separately: nz=0, rows=NULL, coefs=NULL
-    Cbc_addCol(model, var_name, 0.0, 1e10, 1.0, 1, 0, NULL, NULL);
-  }
-
-  // Add rows (constraints): one for each counter
-  // Each constraint: sum(button_presses[b] * effect[b][c]) = target[c]
-  for (int c = 0; c < machine->num_counters; c++) {
-    // Count how many buttons affect this counter
-    int nz = 0;
+    sys->pivot_coef[r] = m[r][sys->pivot_col[r]] / g;
+    sys->rhs[r] = m[r][cols] / g;
 
-    for (int b = 0; b < machine->num_buttons; b++) {
-      if (machine->button_effects[b][c] == 1)
-        nz++;
-    }
+    for (int f = 0; f < sys->num_free; f++)
+      sys->coef[r][f] = m[r][sys->free_col[f]] / g;
+  }
 
-    if (nz == 0)
-      // No buttons affect this counter (shouldn't happen 🤷🏽‍♂️)
-      continue;
+  // A button can't be pressed more often than any counter it feeds needs
+  // Each free press also moves the pivot buttons, which sets its weight in
+  // the total.
+  for (int f = 0; f < sys->num_free; f++) {
+    int b = sys->free_col[f];
+    int upper = -1;
 
-    // Build arrays of column indices and coefficients
-    int *cols = malloc(nz * sizeof(int));
-    double *coefs = malloc(nz * sizeof(double));
+    for (int c = 0; c < rows; c++)
+      if (machine_bit(machine->buttons + b * machine->words, c) &&
+          (upper < 0 || machine->counters[c] < upper))
+        upper = machine->counters[c];
 
-    int idx = 0;
-    for (int b = 0; b < machine->num_buttons; b++) {
-      if (machine->button_effects[b][c] == 1) {
-        cols[idx] = b;
-        coefs[idx] = 1.0;
+    sys->upper[f] = upper < 0 ? 0 : upper;
+    sys->weight[f] = 1.0;
 
-        idx++;
-      }
-    }
+    for (int r = 0; r < rank; r++)
+      sys->weight[f] -= (double)sys->coef[r][f] / sys->pivot_coef[r];
+  }
 
-    char constraint_name[32];
-    snprintf(constraint_name, sizeof(constraint_name), "counter_%d", c);
+  return 1;
+}
 
-    // Add constraint: sum = target (sense 'E' for equality)
-    Cbc_addRow(model, constraint_name, nz, cols, coefs, 'E',
-               (double)machine->targets[c]);
+// Try every press count for free button f, then the ones after it
+// A branch is cut when some pivot button can no longer land in range, or
+// when even the best case for the rest can't beat the best total so far.
+void search_free(Search *search, int f) {
+  const ReducedSystem *sys = search->sys;
 
-    free(cols);
-    free(coefs);
-  }
+  // Every pivot button is now fixed; it must be a whole, non-negative count
+  if (f == sys->num_free) {
+    int total = search->presses;
 
-  // Solve the model
-  Cbc_solve(model);
+    for (int r = 0; r < sys->rank; r++) {
+      if (search->residual[r] < 0 || search->residual[r] % sys->pivot_coef[r])
+        return;
 
-  // Check if solution found
-  int status = Cbc_isProvenOptimal(model);
+      total += (int)(search->residual[r] / sys->pivot_coef[r]);
+    }
 
-  int result = -1;
-  if (status) {
-    // Get solution
-    const double *solution = Cbc_getColSolution(model);
+    if (total < search->best)
+      search->best = total;
 
-    // Calc total button presses
-    int total = 0;
+    return;
+  }
 
-    for (int b = 0; b < machine->num_buttons; b++)
-      // Round to nearest integer
-      total += (int)(solution[b] + 0.5);
+  // Try the direction that lowers the total first
+  int upper = sys->upper[f];
+  int step = sys->weight[f] < 0 ? -1 : 1;
+  int first = step > 0 ? 0 : upper;
 
-    // Validate solution
-    int valid = 1;
+  for (int i = 0; i <= upper; i++) {
+    int x = first + i * step;
 
-    for (int c = 0; c < machine->num_counters; c++) {
-      int count = 0;
+    for (int r = 0; r < sys->rank; r++)
+      search->residual[r] -= sys->coef[r][f] * x;
+    search->presses += x;
 
-      for (int b = 0; b < machine->num_buttons; b++)
-        count += ((int)(solution[b] + 0.5)) * machine->button_effects[b][c];
+    // Smallest reachable total, from the exact relation between the free
+    // presses and the rest
+    double bound = search->presses + search->bound_sum[f + 1];
+    int feasible = 1;
 
-      if (count != machine->targets[c]) {
-        valid = 0;
+    for (int r = 0; r < sys->rank && feasible; r++) {
+      long long rest = search->residual[r];
 
-        break;
-      }
+      bound += (double)rest / sys->pivot_coef[r];
+      feasible = rest - search->low_sum[f + 1][r] >= 0;
     }
 
-    if (valid) {
-      result = total;
-    }
+    if (feasible && bound < search->best - 1 + 1e-6)
+      search_free(search, f + 1);
+
+    for (int r = 0; r < sys->rank; r++)
+      search->residual[r] += sys->coef[r][f] * x;
+    search->presses -= x;
   }
+}
+
+long long gcd_ll(long long a, long long b) {
+  a = llabs(a);
+  b = llabs(b);
 
-  // Clean up
-  Cbc_deleteModel(model);
+  while (b) {
+    long long t = a % b;
+    a = b;
+    b = t;
+  }
 
-  return result;
+  return a;
 }
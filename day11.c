@@ -4,162 +4,76 @@
  * Author: DannyBimma
  *
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * To compile: gcc -std=c99 -O2 day11.c -pthread -o day11
  */
 
-#include <stdbool.h>
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
-#define MAX_DEVICES 1000
-#define MAX_NAME_LEN 10
-#define MAX_OUTPUTS 50
-#define MAX_LINE_LEN 512
+#include "day11_graph.h"
+#include "day11_levels.h"
+#include "day11_paths.h"
+#include "result_cache.h"
 
-// Create a structure to represent a device and its outputs
-typedef struct {
-  char name[MAX_NAME_LEN];
-  char outputs[MAX_OUTPUTS][MAX_NAME_LEN];
-  int output_count;
-} Device;
+#define DAY11_RESULT_VERSION 1
 
 // Put graph data in global scope
-Device devices[MAX_DEVICES];
-int device_count = 0;
-
-// Prototypes
-int find_device(const char *name);
-int add_device(const char *name);
-void parse_input(const char *filename);
-int count_paths(int current_idx, const char *target, bool *visited);
+Graph graph;
 
 int main(void) {
+  ResultCache results;
+  if (result_cache_open(&results, "day11_input.txt", 11, 1,
+                        DAY11_RESULT_VERSION, 0, NULL))
+    return 0;
+
   // Parse the input file
-  parse_input("day11_input.txt");
+  if (!graph_load(&graph, "day11_input.txt"))
+    return 1;
 
-  printf("Devices parsed: %d\n", device_count);
+  result_printf(&results, "Devices parsed: %d\n", graph.num_nodes);
 
   // Find the starting device
-  int start_idx = find_device("you");
+  int start_idx = graph_find(&graph, "you");
   if (start_idx == -1) {
     fprintf(stderr, "Error: Starting device 'you' not found\n");
 
     return 1;
   }
 
-  // Init visited array
-  bool *visited = calloc(device_count, sizeof(bool));
-  if (!visited) {
-    fprintf(stderr, "Error: Memory allocation failed\n");
-
-    return 1;
-  }
-
-  // Count all paths from "you" to "out"
-  int path_count = count_paths(start_idx, "out", visited);
-
-  printf("\nNumber of paths from 'you' to 'out': %d\n", path_count);
-
-  free(visited);
+  // A missing target just means there are no paths
+  int target_idx = graph_find(&graph, "out");
 
-  return 0;
-}
+  // Count all paths from "you" to "out", a level of the DAG at a time
+  Levels levels;
+  PathCount path_count;
+  int status = levels_build(&graph, &levels);
 
-// Find device index by name and return -1 upon failure
-int find_device(const char *name) {
-  for (int i = 0; i < device_count; i++) {
-    if (strcmp(devices[i].name, name) == 0)
-      return i;
+  if (status) {
+    status =
+        count_paths_levels(&graph, &levels, start_idx, target_idx, &path_count);
+    levels_free(&levels);
   }
-  return -1;
-}
-
-// Add a device to the graph
-// Return its index if it doesn't exist
-int add_device(const char *name) {
-  int idx = find_device(name);
 
-  if (idx == -1) {
-    strncpy(devices[device_count].name, name, MAX_NAME_LEN - 1);
-
-    devices[device_count].name[MAX_NAME_LEN - 1] = '\0';
-    devices[device_count].output_count = 0;
-    idx = device_count;
-
-    device_count++;
-  }
-  return idx;
-}
-
-// Open input file, read it, and build the graph
-void parse_input(const char *filename) {
-  FILE *fp = fopen(filename, "r");
-
-  if (!fp) {
-    fprintf(stderr, "Error: Cannot open file %s\n", filename);
-    exit(1);
-  }
-
-  char line[MAX_LINE_LEN];
-  while (fgets(line, sizeof(line), fp)) {
-    // Remove newline
-    line[strcspn(line, "\n")] = '\0';
-
-    // Parse device name (string before colon)
-    char *colon = strchr(line, ':');
-    if (!colon)
-      continue;
-
-    *colon = '\0';
-    char *device_name = line;
-
-    int device_idx = add_device(device_name);
-
-    // Parse outputs (string after colon)
-    char *outputs_str = colon + 1;
-    char *token = strtok(outputs_str, " \t");
-
-    while (token != NULL) {
-      // Skip empty tokens
-      if (strlen(token) > 0) {
-        // Add this device as an output
-        int out_count = devices[device_idx].output_count;
-        strncpy(devices[device_idx].outputs[out_count], token,
-                MAX_NAME_LEN - 1);
-        devices[device_idx].outputs[out_count][MAX_NAME_LEN - 1] = '\0';
-        devices[device_idx].output_count++;
-
-        // Ensure the output device exists in the list
-        add_device(token);
-      }
-      token = strtok(NULL, " \t");
-    }
-  }
+  if (status == 0)
+    fprintf(stderr, "Error: Memory allocation failed\n");
 
-  fclose(fp);
-}
+  if (status <= 0) {
+    graph_free(&graph);
 
-// DFS to count all paths from current device to target device
-int count_paths(int current_idx, const char *target, bool *visited) {
-  // If target reached, path found
-  if (strcmp(devices[current_idx].name, target) == 0)
     return 1;
+  }
 
-  // Mark current device as visited
-  visited[current_idx] = true;
-
-  int total_paths = 0;
+  char text[PATH_COUNT_DIGITS];
 
-  // Search all outputs
-  for (int i = 0; i < devices[current_idx].output_count; i++) {
-    int next_idx = find_device(devices[current_idx].outputs[i]);
+  result_printf(&results, "\nNumber of paths from 'you' to 'out': %s\n",
+                format_path_count(path_count, text));
 
-    if (next_idx != -1 && !visited[next_idx])
-      total_paths += count_paths(next_idx, target, visited);
-  }
+  graph_free(&graph);
 
-  // Backtrack: unmark current device
-  visited[current_idx] = false;
+  result_cache_finish(&results);
 
-  return total_paths;
+  return 0;
 }
@@ -0,0 +1,357 @@
+/*
+ * Routine: Advent of Code--Day 11: Device Graph
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * Device names are interned once through a hash table into dense integer
+ * IDs, and the graph is kept in compressed sparse row form: the outputs of
+ * device i are targets[offsets[i]] .. targets[offsets[i + 1] - 1]. Parsing is
+ * linear in the input, and nothing after it touches a string again.
+ *
+ * The whole graph, names and hash table included, is kept in the input
+ * cache (see input_cache.h); later runs on the same input use it in place.
+ *
+ * Needs _POSIX_C_SOURCE 200809L.
+ */
+
+#ifndef DAY11_GRAPH_H
+#define DAY11_GRAPH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "input_cache.h"
+
+#define DAY11_INPUT_KIND INPUT_CACHE_KIND(11, 1)
+
+typedef struct {
+  int num_nodes, num_edges;
+  int *offsets; // num_nodes + 1 entries
+  int *targets; // num_edges entries
+
+  // Names, NUL-terminated and packed, node i's at names + name_start[i]
+  char *names;
+  size_t names_used, names_capacity;
+  int *name_start;
+  int nodes_capacity;
+
+  // Open-addressing table of node IDs, -1 for a free slot
+  int *slots;
+  size_t slot_mask;
+
+  InputCache input; // Holds all of the above when it's cached
+} Graph;
+
+// Sizes of the arrays, the first section of the cached graph
+typedef struct {
+  int64_t num_nodes, num_edges, names_used, slot_mask;
+} CachedGraph;
+
+static inline void graph_free(Graph *graph) {
+  if (!input_cache_hit(&graph->input)) {
+    free(graph->offsets);
+    free(graph->targets);
+    free(graph->names);
+    free(graph->name_start);
+    free(graph->slots);
+  }
+
+  input_cache_close(&graph->input);
+
+  graph->offsets = graph->targets = graph->name_start = graph->slots = NULL;
+  graph->names = NULL;
+}
+
+static inline const char *graph_name(const Graph *graph, int id) {
+  return graph->names + graph->name_start[id];
+}
+
+// FNV-1a over the name's bytes
+static inline uint64_t graph_hash(const char *name, size_t len) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for (size_t i = 0; i < len; i++)
+    hash = (hash ^ (unsigned char)name[i]) * 0x100000001b3ULL;
+
+  return hash;
+}
+
+// Slot holding name, or the free slot where it belongs
+static inline size_t graph_slot(const Graph *graph, const char *name,
+                                size_t len) {
+  size_t slot = graph_hash(name, len) & graph->slot_mask;
+
+  while (graph->slots[slot] >= 0) {
+    const char *other = graph_name(graph, graph->slots[slot]);
+
+    if (strncmp(other, name, len) == 0 && other[len] == '\0')
+      break;
+
+    slot = (slot + 1) & graph->slot_mask;
+  }
+
+  return slot;
+}
+
+// ID of a device by name, or -1 if there's no such device
+static inline int graph_find(const Graph *graph, const char *name) {
+  return graph->slots[graph_slot(graph, name, strlen(name))];
+}
+
+// Double the hash table once it's half full
+static inline int graph_grow_slots(Graph *graph) {
+  size_t size = (graph->slot_mask + 1) * 2;
+  int *slots = malloc(size * sizeof(int));
+  if (!slots)
+    return 0;
+
+  int *old = graph->slots;
+  graph->slots = slots;
+  graph->slot_mask = size - 1;
+
+  for (size_t i = 0; i < size; i++)
+    slots[i] = -1;
+
+  for (int id = 0; id < graph->num_nodes; id++) {
+    const char *name = graph_name(graph, id);
+
+    slots[graph_slot(graph, name, strlen(name))] = id;
+  }
+
+  free(old);
+
+  return 1;
+}
+
+// ID for a name, adding the device if it's new; -1 if memory runs out
+static inline int graph_intern(Graph *graph, const char *name, size_t len) {
+  size_t slot = graph_slot(graph, name, len);
+
+  if (graph->slots[slot] >= 0)
+    return graph->slots[slot];
+
+  if (graph->num_nodes == graph->nodes_capacity) {
+    int capacity = graph->nodes_capacity ? graph->nodes_capacity * 2 : 1024;
+    int *grown = realloc(graph->name_start, capacity * sizeof(int));
+
+    if (!grown)
+      return -1;
+    graph->name_start = grown;
+    graph->nodes_capacity = capacity;
+  }
+
+  if (graph->names_used + len + 1 > graph->names_capacity) {
+    size_t capacity = graph->names_capacity ? graph->names_capacity * 2 : 4096;
+
+    while (capacity < graph->names_used + len + 1)
+      capacity *= 2;
+
+    char *grown = realloc(graph->names, capacity);
+    if (!grown)
+      return -1;
+    graph->names = grown;
+    graph->names_capacity = capacity;
+  }
+
+  int id = graph->num_nodes++;
+
+  graph->name_start[id] = (int)graph->names_used;
+  memcpy(graph->names + graph->names_used, name, len);
+  graph->names[graph->names_used + len] = '\0';
+  graph->names_used += len + 1;
+  graph->slots[slot] = id;
+
+  if ((size_t)graph->num_nodes * 2 > graph->slot_mask + 1 &&
+      !graph_grow_slots(graph))
+    return -1;
+
+  return id;
+}
+
+static inline int graph_is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Point the graph at its cached arrays, return 0 if they don't fit together
+static inline int graph_load_cached(Graph *graph) {
+  const InputCache *input = &graph->input;
+  size_t sizes[6];
+  const void *sections[6];
+
+  for (int i = 0; i < 6; i++)
+    if (!(sections[i] = input_cache_section(input, i, &sizes[i])))
+      return 0;
+
+  const CachedGraph *cached = sections[0];
+  uint64_t slots = (uint64_t)cached->slot_mask + 1;
+
+  if (sizes[0] != sizeof(CachedGraph) || cached->num_nodes < 0 ||
+      cached->num_nodes >= INT32_MAX || cached->num_edges < 0 ||
+      cached->num_edges >= INT32_MAX || (slots & (slots - 1)) != 0 ||
+      sizes[1] != (cached->num_nodes + 1) * sizeof(int) ||
+      sizes[2] != cached->num_edges * sizeof(int) ||
+      sizes[3] != (uint64_t)cached->names_used ||
+      sizes[4] != cached->num_nodes * sizeof(int) ||
+      sizes[5] != slots * sizeof(int))
+    return 0;
+
+  // Read only: a loaded graph never interns another name
+  graph->num_nodes = graph->nodes_capacity = (int)cached->num_nodes;
+  graph->num_edges = (int)cached->num_edges;
+  graph->offsets = (int *)sections[1];
+  graph->targets = (int *)sections[2];
+  graph->names = (char *)sections[3];
+  graph->names_used = graph->names_capacity = cached->names_used;
+  graph->name_start = (int *)sections[4];
+  graph->slots = (int *)sections[5];
+  graph->slot_mask = cached->slot_mask;
+
+  return 1;
+}
+
+// Save the graph for the next run on the same input
+static inline void graph_store(Graph *graph) {
+  CachedGraph cached = {graph->num_nodes, graph->num_edges,
+                        (int64_t)graph->names_used,
+                        (int64_t)graph->slot_mask};
+  const void *sections[] = {&cached,      graph->offsets,    graph->targets,
+                            graph->names, graph->name_start, graph->slots};
+  size_t sizes[] = {sizeof(cached),
+                    (graph->num_nodes + 1) * sizeof(int),
+                    graph->num_edges * sizeof(int),
+                    graph->names_used,
+                    graph->num_nodes * sizeof(int),
+                    (graph->slot_mask + 1) * sizeof(int)};
+
+  input_cache_store(&graph->input, 6, sections, sizes);
+}
+
+// Read "name: output output ..." lines into the graph
+// Edges are gathered as pairs, then bucketed by source into CSR. Returns 0
+// on failure, after reporting it.
+static inline int graph_load(Graph *graph, const char *filename) {
+  memset(graph, 0, sizeof(*graph));
+
+  // The whole file is mapped, so lines can be any length
+  if (!input_cache_open(&graph->input, filename, DAY11_INPUT_KIND, 0)) {
+    fprintf(stderr, "Error: Cannot open file %s\n", filename);
+
+    return 0;
+  }
+
+  if (input_cache_hit(&graph->input)) {
+    if (graph_load_cached(graph))
+      return 1;
+
+    input_cache_reject(&graph->input);
+  }
+
+  const char *text = graph->input.text;
+  size_t size = graph->input.size;
+  int *sources = NULL, *targets = NULL;
+  size_t num_edges = 0, edges_capacity = 0;
+
+  graph->slots = malloc(1024 * sizeof(int));
+  graph->slot_mask = 1023;
+  int ok = graph->slots != NULL;
+
+  if (graph->slots)
+    for (size_t i = 0; i < 1024; i++)
+      graph->slots[i] = -1;
+
+  for (size_t pos = 0; ok && pos < size;) {
+    const char *line = text + pos;
+    const char *end = memchr(line, '\n', size - pos);
+    if (!end)
+      end = text + size;
+    pos = end - text + 1;
+
+    // Device name is everything before the colon
+    const char *colon = memchr(line, ':', end - line);
+    if (!colon)
+      continue;
+
+    int source = graph_intern(graph, line, colon - line);
+    ok = source >= 0;
+
+    for (const char *p = colon + 1; ok && p < end;) {
+      while (p < end && graph_is_space(*p))
+        p++;
+
+      const char *token = p;
+      while (p < end && !graph_is_space(*p))
+        p++;
+
+      if (p == token)
+        continue;
+
+      if (num_edges == edges_capacity) {
+        edges_capacity = edges_capacity ? edges_capacity * 2 : 4096;
+        int *grown_sources = realloc(sources, edges_capacity * sizeof(int));
+        if (grown_sources)
+          sources = grown_sources;
+        int *grown_targets = realloc(targets, edges_capacity * sizeof(int));
+        if (grown_targets)
+          targets = grown_targets;
+
+        if (!grown_sources || !grown_targets) {
+          ok = 0;
+          break;
+        }
+      }
+
+      int target = graph_intern(graph, token, p - token);
+      ok = target >= 0;
+      if (!ok)
+        break;
+
+      sources[num_edges] = source;
+      targets[num_edges] = target;
+      num_edges++;
+    }
+  }
+
+  // Bucket the edges by source, keeping their input order
+  if (ok) {
+    graph->num_edges = (int)num_edges;
+    graph->offsets = calloc(graph->num_nodes + 1, sizeof(int));
+    graph->targets = malloc((num_edges ? num_edges : 1) * sizeof(int));
+    ok = graph->offsets && graph->targets;
+  }
+
+  if (ok) {
+    for (size_t e = 0; e < num_edges; e++)
+      graph->offsets[sources[e] + 1]++;
+
+    for (int i = 0; i < graph->num_nodes; i++)
+      graph->offsets[i + 1] += graph->offsets[i];
+
+    for (size_t e = 0; e < num_edges; e++)
+      graph->targets[graph->offsets[sources[e]]++] = targets[e];
+
+    // Filling advanced each offset to the next node's start
+    for (int i = graph->num_nodes; i > 0; i--)
+      graph->offsets[i] = graph->offsets[i - 1];
+    graph->offsets[0] = 0;
+  }
+
+  free(sources);
+  free(targets);
+
+  if (!ok) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
+    graph_free(graph);
+
+    return 0;
+  }
+
+  graph_store(graph);
+
+  return 1;
+}
+
+#endif
@@ -0,0 +1,337 @@
+/*
+ * Routine: Advent of Code--Day 11: Level-Parallel Path Counting
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * Splits the device graph into topological levels, a device's level being
+ * the longest path into it, so every input of a device sits on an earlier
+ * level. Paths are then counted level by level, each device pulling the sum
+ * of its inputs' counts through a transposed CSR. A device is written by one
+ * thread and only read once its level is done, so no atomics are needed,
+ * just a barrier between levels. Runs of small levels go to one thread
+ * between barriers, since splitting them costs more than it saves.
+ *
+ * Graphs with a cycle anywhere fall back to the serial Tarjan count, which
+ * can tell cycles that matter from ones that don't.
+ *
+ * Needs _POSIX_C_SOURCE 200809L and -pthread.
+ */
+
+#ifndef DAY11_LEVELS_H
+#define DAY11_LEVELS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "day11_graph.h"
+#include "day11_paths.h"
+#include "work_pool.h"
+
+#define PARALLEL_LEVEL_WORK 16384 // Devices plus inputs worth splitting
+
+typedef struct {
+  // Transposed CSR: the inputs of device i are
+  // in_sources[in_offsets[i]] .. in_sources[in_offsets[i + 1] - 1]
+  int *in_offsets, *in_sources;
+
+  // Devices by level, level l's at by_level[level_start[l]] ..
+  int *by_level, *level_start, *level;
+  int num_levels;
+  int num_leveled; // Fewer than num_nodes when the graph has a cycle
+
+  // Phases between barriers: levels phase_start[p] .. phase_start[p + 1] - 1,
+  // split across threads if phase_parallel[p]
+  int *phase_start;
+  bool *phase_parallel;
+  int num_phases;
+} Levels;
+
+// One level-parallel count in progress
+typedef struct {
+  const Levels *levels;
+  int source, target, first_level, last_level, threads;
+  PathCount *count;
+  pthread_barrier_t barrier;
+
+  // Workers wait here until the number that started is known
+  pthread_mutex_t gate_lock;
+  pthread_cond_t gate;
+  bool open;
+} LevelCount;
+
+typedef struct {
+  LevelCount *run;
+  int id;
+} LevelWorker;
+
+static inline void levels_free(Levels *levels) {
+  free(levels->in_offsets);
+  free(levels->in_sources);
+  free(levels->by_level);
+  free(levels->level_start);
+  free(levels->level);
+  free(levels->phase_start);
+  free(levels->phase_parallel);
+
+  levels->in_offsets = levels->in_sources = NULL;
+  levels->by_level = levels->level_start = levels->level = NULL;
+  levels->phase_start = NULL;
+  levels->phase_parallel = NULL;
+}
+
+// Transpose the graph and level it, once per graph
+// Returns 0 if memory runs out.
+static inline int levels_build(const Graph *graph, Levels *levels) {
+  int n = graph->num_nodes, m = graph->num_edges;
+  size_t size = n ? n : 1;
+
+  levels->in_offsets = calloc(n + 1, sizeof(int));
+  levels->in_sources = malloc((m ? m : 1) * sizeof(int));
+  levels->by_level = malloc(size * sizeof(int));
+  levels->level_start = malloc((n + 1) * sizeof(int));
+  levels->level = malloc(size * sizeof(int));
+  levels->phase_start = malloc((n + 1) * sizeof(int));
+  levels->phase_parallel = malloc(size * sizeof(bool));
+  levels->num_levels = levels->num_leveled = levels->num_phases = 0;
+
+  int *pending = malloc(size * sizeof(int)); // Inputs not yet leveled
+
+  if (!levels->in_offsets || !levels->in_sources || !levels->by_level ||
+      !levels->level_start || !levels->level || !levels->phase_start ||
+      !levels->phase_parallel || !pending) {
+    free(pending);
+    levels_free(levels);
+
+    return 0;
+  }
+
+  // Bucket every edge by its target
+  int *in_offsets = levels->in_offsets;
+
+  for (int e = 0; e < m; e++)
+    in_offsets[graph->targets[e] + 1]++;
+
+  for (int v = 0; v < n; v++) {
+    in_offsets[v + 1] += in_offsets[v];
+    pending[v] = in_offsets[v + 1] - in_offsets[v];
+  }
+
+  for (int u = 0; u < n; u++)
+    for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++)
+      levels->in_sources[in_offsets[graph->targets[e]]++] = u;
+
+  // Filling advanced each offset to the next device's start
+  for (int v = n; v > 0; v--)
+    in_offsets[v] = in_offsets[v - 1];
+  in_offsets[0] = 0;
+
+  // Kahn's algorithm a level at a time: a device joins the level after the
+  // one its last input was on
+  int *by_level = levels->by_level, *level = levels->level;
+  int count = 0;
+
+  for (int v = 0; v < n; v++) {
+    level[v] = -1;
+
+    if (pending[v] == 0)
+      by_level[count++] = v;
+  }
+
+  for (int begin = 0; begin < count;) {
+    int end = count, l = levels->num_levels++;
+
+    levels->level_start[l] = begin;
+
+    for (int i = begin; i < end; i++) {
+      int u = by_level[i];
+
+      level[u] = l;
+      for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++)
+        if (--pending[graph->targets[e]] == 0)
+          by_level[count++] = graph->targets[e];
+    }
+
+    begin = end;
+  }
+
+  levels->level_start[levels->num_levels] = count;
+  levels->num_leveled = count;
+  free(pending);
+
+  // Merge runs of small levels into serial phases
+  for (int l = 0; l < levels->num_levels; l++) {
+    int work = 0;
+
+    for (int i = levels->level_start[l]; i < levels->level_start[l + 1]; i++)
+      work += 1 + in_offsets[by_level[i] + 1] - in_offsets[by_level[i]];
+
+    bool parallel = work >= PARALLEL_LEVEL_WORK;
+    int p = levels->num_phases;
+
+    if (parallel || p == 0 || levels->phase_parallel[p - 1]) {
+      levels->phase_start[p] = l;
+      levels->phase_parallel[p] = parallel;
+      levels->num_phases++;
+    }
+  }
+
+  levels->phase_start[levels->num_phases] = levels->num_levels;
+
+  return 1;
+}
+
+// Count the paths into the devices at by_level[begin .. end)
+static inline void level_pull(const LevelCount *run, int begin, int end) {
+  const Levels *levels = run->levels;
+  PathCount *count = run->count;
+
+  for (int i = begin; i < end; i++) {
+    int v = levels->by_level[i];
+    PathCount sum = v == run->source;
+
+    // Paths end at the target, so nothing is pulled through it
+    for (int e = levels->in_offsets[v]; e < levels->in_offsets[v + 1]; e++) {
+      int u = levels->in_sources[e];
+
+      if (u != run->target)
+        sum += count[u];
+    }
+
+    count[v] = sum;
+  }
+}
+
+static inline void *level_worker(void *arg) {
+  LevelWorker *worker = arg;
+  LevelCount *run = worker->run;
+  const Levels *levels = run->levels;
+
+  pthread_mutex_lock(&run->gate_lock);
+  while (!run->open)
+    pthread_cond_wait(&run->gate, &run->gate_lock);
+  pthread_mutex_unlock(&run->gate_lock);
+
+  if (worker->id >= run->threads)
+    return NULL;
+
+  for (int p = 0; p < levels->num_phases; p++) {
+    // Only the levels from the source's to the target's matter
+    int first = levels->phase_start[p], last = levels->phase_start[p + 1] - 1;
+
+    if (first < run->first_level)
+      first = run->first_level;
+    if (last > run->last_level)
+      last = run->last_level;
+    if (first > last)
+      continue;
+
+    int begin = levels->level_start[first], end = levels->level_start[last + 1];
+
+    if (levels->phase_parallel[p]) {
+      long long size = end - begin;
+
+      level_pull(run, begin + (int)(size * worker->id / run->threads),
+                 begin + (int)(size * (worker->id + 1) / run->threads));
+    } else if (worker->id == 0) {
+      level_pull(run, begin, end);
+    }
+
+    if (run->threads > 1)
+      pthread_barrier_wait(&run->barrier);
+  }
+
+  return NULL;
+}
+
+// Number of paths from source to target, into *paths, across all cores
+// Same contract as count_paths_dag(): 1 on success, -1 if a cycle lies on
+// some path and 0 if memory runs out.
+static inline int count_paths_levels(const Graph *graph, const Levels *levels,
+                                     int source, int target,
+                                     PathCount *paths) {
+  if (levels->num_leveled < graph->num_nodes)
+    return count_paths_dag(graph, source, target, paths);
+
+  *paths = 0;
+
+  if (target < 0 || levels->level[target] < levels->level[source])
+    return 1;
+
+  LevelCount run;
+  run.levels = levels;
+  run.source = source;
+  run.target = target;
+  run.first_level = levels->level[source];
+  run.last_level = levels->level[target];
+  run.threads = pool_num_workers();
+  run.count = calloc(graph->num_nodes, sizeof(PathCount));
+
+  if (!run.count)
+    return 0;
+
+  // No parallel phase in range means nothing to split
+  bool any_parallel = false;
+
+  for (int p = 0; p < levels->num_phases; p++)
+    any_parallel |= levels->phase_parallel[p] &&
+                    levels->phase_start[p + 1] > run.first_level &&
+                    levels->phase_start[p] <= run.last_level;
+
+  LevelWorker *workers = malloc(run.threads * sizeof(LevelWorker));
+  pthread_t *ids = malloc(run.threads * sizeof(pthread_t));
+  LevelWorker serial = {&run, 0};
+
+  if (!any_parallel || run.threads < 2 || !workers || !ids)
+    run.threads = 1;
+
+  pthread_mutex_init(&run.gate_lock, NULL);
+  pthread_cond_init(&run.gate, NULL);
+  run.open = false;
+
+  int started = 1;
+
+  for (int t = 1; t < run.threads; t++) {
+    workers[t].run = &run;
+    workers[t].id = t;
+
+    if (pthread_create(&ids[t], NULL, level_worker, &workers[t]) != 0)
+      break;
+    started++;
+  }
+
+  // Split across the threads that did start; any trouble means running
+  // alone, and the others leave as soon as the gate opens
+  if (started < 2 || pthread_barrier_init(&run.barrier, NULL, started) != 0)
+    run.threads = 1;
+  else
+    run.threads = started;
+
+  pthread_mutex_lock(&run.gate_lock);
+  run.open = true;
+  pthread_cond_broadcast(&run.gate);
+  pthread_mutex_unlock(&run.gate_lock);
+
+  level_worker(&serial);
+
+  for (int t = 1; t < started; t++)
+    pthread_join(ids[t], NULL);
+
+  if (run.threads > 1)
+    pthread_barrier_destroy(&run.barrier);
+
+  pthread_mutex_destroy(&run.gate_lock);
+  pthread_cond_destroy(&run.gate);
+
+  *paths = run.count[target];
+
+  free(workers);
+  free(ids);
+  free(run.count);
+
+  return 1;
+}
+
+#endif
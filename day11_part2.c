@@ -4,209 +4,486 @@
  * Author: DannyBimma
  *
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * Usage: day11_part2 [source target [waypoint ...]]
+ *        day11_part2 --serve [--cache targets] [socket]
+ *
+ * Counts the paths from source to target that pass through every waypoint,
+ * up to MAX_WAYPOINTS of them. With no arguments it answers the puzzle:
+ * paths from "svr" to "out" visiting both "dac" and "fft".
+ *
+ * --serve loads the graph once and answers "source target [waypoint ...]"
+ * lines from stdin, or from each client of a Unix socket in turn, with the
+ * latency of every query. The path counts into each target are computed on
+ * first use and kept for the most recently used targets. A stale socket at
+ * the socket path is replaced, but any other file there is left alone.
  */
 
-#include <stdbool.h>
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "day11_graph.h"
+#include "day11_paths.h"
+#include "result_cache.h"
 
-#define MAX_DEVICES 1000
-#define MAX_NAME_LEN 10
-#define MAX_OUTPUTS 50
-#define MAX_LINE_LEN 512
+#define DEFAULT_CACHED_TARGETS 64
+#define DAY11_RESULT_VERSION 1
 
-// Create a structure to represent a device and its outputs
+// Path counts from every device into one target
 typedef struct {
-  char name[MAX_NAME_LEN];
-  char outputs[MAX_OUTPUTS][MAX_NAME_LEN];
-  int output_count;
-} Device;
+  int target; // -1 while the entry is unused
+  unsigned long long last_used;
+  PathCount *count;
+  bool *tainted;
+} TargetCounts;
 
 // Put graph data in global scope
-Device devices[MAX_DEVICES];
-int device_count = 0;
+Graph graph;
+
+// Whole-graph order and the cache of target counts, for --serve
+int *order = NULL, *component = NULL;
+TargetCounts *cache = NULL;
+int cache_size = 0;
+unsigned long long cache_clock = 0;
+long long cache_hits = 0, cache_misses = 0;
 
 // Prototypes
-int find_device(const char *name);
-int add_device(const char *name);
-void parse_input(const char *filename);
-void init_memo();
-long long count_paths_with_required(int current_idx, const char *target,
-                                    bool *visited, bool seen_dac,
-                                    bool seen_fft);
-
-int main(void) {
-  // Parse the input file
-  parse_input("day11_input.txt");
+int serve(const char *socket_path, int cached_targets);
+void serve_stream(FILE *in, FILE *out);
+void answer_query(char *line, FILE *out);
+int cached_paths(int source, int target, const int *waypoints,
+                 int num_waypoints, PathCount *paths);
+TargetCounts *target_counts(int target);
+void free_cache(void);
+
+int main(int argc, char *argv[]) {
+  static const char *puzzle[] = {"svr", "out", "dac", "fft"};
+  const char **query = (const char **)argv + 1;
+  int num_names = argc - 1;
+
+  if (num_names > 0 && strcmp(query[0], "--serve") == 0) {
+    const char *socket_path = NULL;
+    int cached_targets = DEFAULT_CACHED_TARGETS;
+
+    // Anything unexpected is an error, as the socket path gets replaced
+    for (int i = 1; i < num_names; i++) {
+      if (strcmp(query[i], "--cache") == 0 && i + 1 < num_names) {
+        cached_targets = atoi(query[++i]);
+      } else if (strncmp(query[i], "--", 2) == 0 || socket_path) {
+        fprintf(stderr,
+                "Error: Unexpected argument '%s'\n"
+                "Usage: %s --serve [--cache targets] [socket]\n",
+                query[i], argv[0]);
+
+        return 1;
+      } else {
+        socket_path = query[i];
+      }
+    }
+
+    if (cached_targets < 1) {
+      fprintf(stderr, "Error: --cache needs at least 1 target\n");
+
+      return 1;
+    }
+
+    return serve(socket_path, cached_targets);
+  }
 
-  printf("Devices parsed: %d\n", device_count);
+  if (num_names == 0) {
+    query = puzzle;
+    num_names = 4;
+  }
+
+  if (num_names < 2 || num_names - 2 > MAX_WAYPOINTS) {
+    fprintf(stderr, "Usage: %s [source target [waypoint ...]] (at most %d "
+                    "waypoints)\n",
+            argv[0], MAX_WAYPOINTS);
 
-  // Find the starting device "svr"
-  int start_idx = find_device("svr");
+    return 1;
+  }
+
+  // A repeat run of the same query on the same input just replays the answer
+  ResultCache results;
+  if (result_cache_open(&results, "day11_input.txt", 11, 2,
+                        DAY11_RESULT_VERSION, argc, argv))
+    return 0;
+
+  // Parse the input file
+  if (!graph_load(&graph, "day11_input.txt"))
+    return 1;
 
+  result_printf(&results, "Devices parsed: %d\n", graph.num_nodes);
+
+  // Find the starting device
+  int start_idx = graph_find(&graph, query[0]);
   if (start_idx == -1) {
-    fprintf(stderr, "Error: Starting device 'svr' not found\n");
+    fprintf(stderr, "Error: Starting device '%s' not found\n", query[0]);
+    graph_free(&graph);
+
     return 1;
   }
 
-  // Init visited array
-  bool *visited = calloc(device_count, sizeof(bool));
-  if (!visited) {
+  // Missing devices just mean there are no such paths
+  int target_idx = graph_find(&graph, query[1]);
+  int num_waypoints = num_names - 2;
+  int waypoints[MAX_WAYPOINTS];
+
+  for (int i = 0; i < num_waypoints; i++)
+    waypoints[i] = graph_find(&graph, query[i + 2]);
+
+  PathCount path_count;
+  int status = count_paths_via(&graph, start_idx, target_idx, waypoints,
+                               num_waypoints, &path_count);
+
+  if (status == 0)
     fprintf(stderr, "Error: Memory allocation failed\n");
+
+  if (status <= 0) {
+    graph_free(&graph);
+
     return 1;
   }
 
-  // Init memoization table
-  init_memo();
+  result_printf(&results, "\nNumber of paths from '%s' to '%s':", query[0],
+                query[1]);
+
+  if (num_waypoints == 2) {
+    result_printf(&results, " visiting both '%s' and '%s':", query[2],
+                  query[3]);
+  } else if (num_waypoints > 0) {
+    result_printf(&results, " visiting");
+    for (int i = 0; i < num_waypoints; i++)
+      result_printf(&results, "%s '%s'", i ? "," : "", query[i + 2]);
+    result_printf(&results, ":");
+  }
 
-  // Count paths from "svr" to "out" that visit both "dac" and "fft"
-  long long path_count =
-      count_paths_with_required(start_idx, "out", visited, false, false);
+  char text[PATH_COUNT_DIGITS];
 
-  printf("\nNumber of paths from 'svr' to 'out': visiting both 'dac' and "
-         "'fft': %lld\n",
-         path_count);
+  result_printf(&results, " %s\n", format_path_count(path_count, text));
 
-  free(visited);
+  graph_free(&graph);
+  result_cache_finish(&results);
 
   return 0;
 }
 
-// Find device index by name and return -1 upon failure
-int find_device(const char *name) {
-  for (int i = 0; i < device_count; i++)
-    if (strcmp(devices[i].name, name) == 0)
-      return i;
+// Load the graph once, then answer queries until the input ends
+// Without a socket path, queries come from stdin. Returns the exit status.
+int serve(const char *socket_path, int cached_targets) {
+  if (!graph_load(&graph, "day11_input.txt"))
+    return 1;
 
-  return -1;
-}
+  int n = graph.num_nodes ? graph.num_nodes : 1;
 
-// Add a device to the graph
-// Return its index if it doesn't exist
-int add_device(const char *name) {
-  int idx = find_device(name);
+  order = malloc(n * sizeof(int));
+  component = malloc(n * sizeof(int));
+  cache = malloc(cached_targets * sizeof(TargetCounts));
+  cache_size = cached_targets;
 
-  if (idx == -1) {
-    strncpy(devices[device_count].name, name, MAX_NAME_LEN - 1);
+  for (int i = 0; cache && i < cache_size; i++) {
+    cache[i].target = -1;
+    cache[i].last_used = 0;
+    cache[i].count = NULL;
+    cache[i].tainted = NULL;
+  }
 
-    devices[device_count].name[MAX_NAME_LEN - 1] = '\0';
-    devices[device_count].output_count = 0;
-    idx = device_count;
+  if (!order || !component || !cache ||
+      !graph_order(&graph, order, component)) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
+    free_cache();
+    graph_free(&graph);
 
-    device_count++;
+    return 1;
   }
-  return idx;
-}
 
-// Open input file, read it, and build the graph
-void parse_input(const char *filename) {
-  FILE *fp = fopen(filename, "r");
+  fprintf(stderr, "Serving %d devices, caching up to %d targets\n",
+          graph.num_nodes, cache_size);
+
+  int status = 0;
+
+  if (!socket_path) {
+    serve_stream(stdin, stdout);
+  } else {
+    struct sockaddr_un addr;
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    struct stat existing;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+      fprintf(stderr, "Error: Socket path too long: %s\n", socket_path);
+      status = 1;
+    } else if (lstat(socket_path, &existing) == 0 &&
+               !S_ISSOCK(existing.st_mode)) {
+      // Only a socket left behind by an earlier server is ever replaced
+      fprintf(stderr, "Error: Cannot listen on %s: %s\n", socket_path,
+              strerror(EADDRINUSE));
+      status = 1;
+    } else {
+      strcpy(addr.sun_path, socket_path);
+      unlink(socket_path);
+
+      if (listener < 0 ||
+          bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+          listen(listener, 16) != 0) {
+        fprintf(stderr, "Error: Cannot listen on %s: %s\n", socket_path,
+                strerror(errno));
+        status = 1;
+      }
+    }
+
+    // One client at a time, each until it closes its end
+    while (status == 0) {
+      int client = accept(listener, NULL, NULL);
+
+      if (client < 0) {
+        if (errno == EINTR)
+          continue;
+
+        fprintf(stderr, "Error: accept failed: %s\n", strerror(errno));
+        status = 1;
+        break;
+      }
+
+      int reply = dup(client);
+      FILE *in = fdopen(client, "r");
+      FILE *out = reply >= 0 ? fdopen(reply, "w") : NULL;
 
-  if (!fp) {
-    fprintf(stderr, "Error: Cannot open file %s\n", filename);
-    exit(1);
+      if (in && out)
+        serve_stream(in, out);
+
+      if (in)
+        fclose(in);
+      else
+        close(client);
+
+      if (out)
+        fclose(out);
+      else if (reply >= 0)
+        close(reply);
+    }
+
+    if (listener >= 0)
+      close(listener);
   }
 
-  char line[MAX_LINE_LEN];
-  while (fgets(line, sizeof(line), fp)) {
-    // Remove newline
-    line[strcspn(line, "\n")] = '\0';
+  fprintf(stderr, "Target cache: %lld hits, %lld misses\n", cache_hits,
+          cache_misses);
 
-    // Parse device name (string before colon)
-    char *colon = strchr(line, ':');
-    if (!colon)
-      continue;
+  free_cache();
+  graph_free(&graph);
 
-    *colon = '\0';
-    char *device_name = line;
+  return status;
+}
 
-    int device_idx = add_device(device_name);
+// Answer every query line from in on out, until in ends
+void serve_stream(FILE *in, FILE *out) {
+  char *line = NULL;
+  size_t capacity = 0;
 
-    // Parse outputs (string after colon)
-    char *outputs_str = colon + 1;
-    char *token = strtok(outputs_str, " \t");
+  while (getline(&line, &capacity, in) != -1) {
+    answer_query(line, out);
+    fflush(out);
+  }
 
-    while (token != NULL) {
-      // Skip empty tokens
-      if (strlen(token) > 0) {
-        // Add this device as an output
-        int out_count = devices[device_idx].output_count;
-        strncpy(devices[device_idx].outputs[out_count], token,
-                MAX_NAME_LEN - 1);
-        devices[device_idx].outputs[out_count][MAX_NAME_LEN - 1] = '\0';
-        devices[device_idx].output_count++;
+  free(line);
+}
 
-        // Ensure the output device exists in the list
-        add_device(token);
-      }
-      token = strtok(NULL, " \t");
+// Answer one "source target [waypoint ...]" line
+// The reply echoes the query, then the count or an error, then the latency.
+void answer_query(char *line, FILE *out) {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  const char *names[MAX_WAYPOINTS + 2];
+  int num_names = 0;
+  char *save = NULL;
+
+  for (char *token = strtok_r(line, " \t\r\n", &save); token;
+       token = strtok_r(NULL, " \t\r\n", &save)) {
+    if (num_names == MAX_WAYPOINTS + 2) {
+      fprintf(out, "Error: At most %d waypoints\n", MAX_WAYPOINTS);
+
+      return;
     }
+
+    names[num_names++] = token;
+  }
+
+  // Skip empty lines
+  if (num_names == 0)
+    return;
+
+  for (int i = 0; i < num_names; i++)
+    fprintf(out, "%s%s", i ? " " : "", names[i]);
+
+  if (num_names < 2) {
+    fprintf(out, ": Error: Need a source and a target\n");
+
+    return;
   }
 
-  fclose(fp);
+  int source = graph_find(&graph, names[0]);
+  int target = graph_find(&graph, names[1]);
+  int waypoints[MAX_WAYPOINTS];
+
+  for (int i = 2; i < num_names; i++)
+    waypoints[i - 2] = graph_find(&graph, names[i]);
+
+  PathCount paths = 0;
+  int status = 1;
+
+  // Missing devices other than the source just mean there are no paths
+  if (source == -1)
+    status = -2;
+  else
+    status = cached_paths(source, target, waypoints, num_names - 2, &paths);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double micros = (end.tv_sec - start.tv_sec) * 1e6 +
+                  (end.tv_nsec - start.tv_nsec) / 1e3;
+
+  if (status == 1) {
+    fprintf(out, ": ");
+    print_path_count(out, paths);
+  } else if (status == -2) {
+    fprintf(out, ": Error: Starting device '%s' not found", names[0]);
+  } else if (status == -1) {
+    fprintf(out, ": Error: Cycle between source and target");
+  } else {
+    fprintf(out, ": Error: Memory allocation failed");
+  }
+
+  fprintf(out, " (%.1f us)\n", micros);
 }
 
-// Memoization table: memo[node_idx][seen_dac][seen_fft] = path count
-// -1 means not yet computed
-static long long memo[MAX_DEVICES][2][2];
-static bool memo_initialized = false;
-
-void init_memo() {
-  if (!memo_initialized) {
-    for (int i = 0; i < MAX_DEVICES; i++) {
-      for (int j = 0; j < 2; j++) {
-        for (int k = 0; k < 2; k++) {
-          memo[i][j][k] = -1;
-        }
-      }
+// Paths from source to target through every waypoint, from cached counts
+// Waypoints are sorted topologically; the answer is the product of the
+// counts between neighbours in the chain source, waypoints..., target. Any
+// cycle near the query falls back to the exact search, which reports real
+// ones. Returns 1 on success, -1 for a cycle and 0 if memory runs out.
+int cached_paths(int source, int target, const int *waypoints,
+                 int num_waypoints, PathCount *paths) {
+  int chain[MAX_WAYPOINTS + 2];
+  int length = 1;
+
+  *paths = 0;
+
+  if (target == -1)
+    return 1;
+
+  chain[0] = source;
+
+  // Later in the order means nearer the source
+  for (int i = 0; i < num_waypoints; i++) {
+    int w = waypoints[i];
+
+    if (w == -1)
+      return 1;
+
+    int j = length++;
+    while (j > 1 && component[chain[j - 1]] < component[w]) {
+      chain[j] = chain[j - 1];
+      j--;
     }
-    memo_initialized = true;
+    chain[j] = w;
+  }
+
+  chain[length++] = target;
+
+  // A cycle between source and target is an error, whatever the waypoints
+  TargetCounts *counts = target_counts(target);
+  if (!counts)
+    return 0;
+
+  bool exact = counts->tainted[source];
+  PathCount product = 1;
+
+  for (int j = 0; !exact && product && j + 1 < length; j++) {
+    counts = target_counts(chain[j + 1]);
+    if (!counts)
+      return 0;
+
+    exact = counts->tainted[chain[j]];
+    product *= counts->count[chain[j]];
   }
+
+  if (exact)
+    return count_paths_via(&graph, source, target, waypoints, num_waypoints,
+                           paths);
+
+  *paths = product;
+
+  return 1;
 }
 
-// DFS to count paths that visit both required nodes with memoization
-// Tracks whether "dac" and "fft" have been visited in the current path
-long long count_paths_with_required(int current_idx, const char *target,
-                                    bool *visited, bool seen_dac,
-                                    bool seen_fft) {
-  // Update if required nodes have been seen
-  if (strcmp(devices[current_idx].name, "dac") == 0)
-    seen_dac = true;
-  if (strcmp(devices[current_idx].name, "fft") == 0)
-    seen_fft = true;
+// Counts into target, computed now unless they're cached
+// Evicts the least recently used target once the cache is full. Returns NULL
+// if memory runs out.
+TargetCounts *target_counts(int target) {
+  TargetCounts *entry = &cache[0];
 
-  // If target reached, check if both required nodes were visited
-  if (strcmp(devices[current_idx].name, target) == 0)
-    return (seen_dac && seen_fft) ? 1 : 0;
+  for (int i = 0; i < cache_size; i++) {
+    if (cache[i].target == target) {
+      cache_hits++;
+      cache[i].last_used = ++cache_clock;
+
+      return &cache[i];
+    }
 
-  // Check memoization table (if not in visited path to avoid cycles)
-  int dac_flag = seen_dac ? 1 : 0;
-  int fft_flag = seen_fft ? 1 : 0;
+    // Unused entries have last_used 0, so they go first
+    if (cache[i].last_used < entry->last_used)
+      entry = &cache[i];
+  }
 
-  if (!visited[current_idx] && memo[current_idx][dac_flag][fft_flag] != -1)
-    return memo[current_idx][dac_flag][fft_flag];
+  cache_misses++;
 
-  // Mark current device as visited
-  visited[current_idx] = true;
+  int n = graph.num_nodes ? graph.num_nodes : 1;
 
-  long long total_paths = 0;
+  if (!entry->count) {
+    entry->count = malloc(n * sizeof(PathCount));
+    entry->tainted = malloc(n * sizeof(bool));
 
-  // Search all outputs
-  for (int i = 0; i < devices[current_idx].output_count; i++) {
-    int next_idx = find_device(devices[current_idx].outputs[i]);
+    if (!entry->count || !entry->tainted) {
+      free(entry->count);
+      free(entry->tainted);
+      entry->count = NULL;
+      entry->tainted = NULL;
 
-    if (next_idx != -1 && !visited[next_idx]) {
-      total_paths += count_paths_with_required(next_idx, target, visited,
-                                               seen_dac, seen_fft);
+      return NULL;
     }
   }
 
-  // Backtrack: unmark current device
-  visited[current_idx] = false;
+  count_paths_to_all(&graph, order, component, target, entry->count,
+                     entry->tainted);
+  entry->target = target;
+  entry->last_used = ++cache_clock;
+
+  return entry;
+}
+
+void free_cache(void) {
+  for (int i = 0; cache && i < cache_size; i++) {
+    free(cache[i].count);
+    free(cache[i].tainted);
+  }
 
-  // Store in memo table
-  memo[current_idx][dac_flag][fft_flag] = total_paths;
+  free(cache);
+  free(order);
+  free(component);
 
-  return total_paths;
+  cache = NULL;
+  order = component = NULL;
 }
@@ -0,0 +1,493 @@
+/*
+ * Routine: Advent of Code--Day 11: Path Counting
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * Counts the paths between two devices in O(V + E). An iterative Tarjan
+ * search from the source finds the strongly connected components, and it
+ * finishes them in reverse topological order, so each device's count is
+ * just the sum over its outputs, all of which are already final. A cycle
+ * that sits between the source and the target would allow endlessly many
+ * paths; those components are reported instead.
+ *
+ * Queries through up to MAX_WAYPOINTS required devices reuse the same order,
+ * either carrying a count per set of waypoints seen or multiplying the path
+ * counts between consecutive waypoints, whichever costs less.
+ */
+
+#ifndef DAY11_PATHS_H
+#define DAY11_PATHS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "day11_graph.h"
+
+#define MAX_WAYPOINTS 16
+
+// 128-bit, since path counts on dense graphs outgrow 64 bits
+typedef unsigned __int128 PathCount;
+
+#define PATH_COUNT_DIGITS 40 // Up to 39 digits, and a NUL
+
+// A path count in decimal, into text with room for PATH_COUNT_DIGITS
+static inline const char *format_path_count(PathCount count, char *text) {
+  char digits[PATH_COUNT_DIGITS];
+  int n = 0, length = 0;
+
+  do {
+    digits[n++] = (char)('0' + (int)(count % 10));
+    count /= 10;
+  } while (count);
+
+  while (n > 0)
+    text[length++] = digits[--n];
+  text[length] = '\0';
+
+  return text;
+}
+
+// Write a path count in decimal
+static inline void print_path_count(FILE *fp, PathCount count) {
+  char text[PATH_COUNT_DIGITS];
+
+  fputs(format_path_count(count, text), fp);
+}
+
+// Report one cyclic component on stderr
+static inline void report_cycle(const Graph *graph, const int *members,
+                                int size) {
+  fprintf(stderr, "Error: Cycle between source and target through:");
+
+  for (int i = 0; i < size && i < 10; i++)
+    fprintf(stderr, " %s", graph_name(graph, members[i]));
+
+  if (size > 10)
+    fprintf(stderr, " ... (%d devices)", size);
+
+  fprintf(stderr, "\n");
+}
+
+// Iterative Tarjan search state, reused across roots
+typedef struct {
+  int *index, *low;
+  int *edge_pos; // Next output to visit
+  int *call;     // DFS path
+  int *stack;    // Tarjan stack
+  bool *on_stack;
+  int next_index, num_components;
+} Tarjan;
+
+static inline void tarjan_free(Tarjan *tarjan) {
+  free(tarjan->index);
+  free(tarjan->low);
+  free(tarjan->edge_pos);
+  free(tarjan->call);
+  free(tarjan->stack);
+  free(tarjan->on_stack);
+}
+
+// Returns 0 if memory runs out
+static inline int tarjan_init(Tarjan *tarjan, int n) {
+  size_t size = n ? n : 1;
+
+  tarjan->index = malloc(size * sizeof(int));
+  tarjan->low = malloc(size * sizeof(int));
+  tarjan->edge_pos = malloc(size * sizeof(int));
+  tarjan->call = malloc(size * sizeof(int));
+  tarjan->stack = malloc(size * sizeof(int));
+  tarjan->on_stack = calloc(size, sizeof(bool));
+  tarjan->next_index = tarjan->num_components = 0;
+
+  if (!tarjan->index || !tarjan->low || !tarjan->edge_pos || !tarjan->call ||
+      !tarjan->stack || !tarjan->on_stack) {
+    tarjan_free(tarjan);
+
+    return 0;
+  }
+
+  for (int v = 0; v < n; v++)
+    tarjan->index[v] = -1;
+
+  return 1;
+}
+
+// Visit every device reachable from root that no earlier root reached
+// Components finish sinks first, so appending each to order as it finishes
+// puts every device after all of its outputs; component[v] numbers them in
+// that order. The outputs of skip are never followed.
+static inline void tarjan_visit(const Graph *graph, Tarjan *tarjan, int root,
+                                int skip, int *order, int *length,
+                                int *component) {
+  int *index = tarjan->index, *low = tarjan->low;
+  int *edge_pos = tarjan->edge_pos, *call = tarjan->call;
+  int *stack = tarjan->stack;
+  bool *on_stack = tarjan->on_stack;
+  int depth = 0, top = 0;
+
+  if (index[root] >= 0)
+    return;
+
+  // Enter the root
+  index[root] = low[root] = tarjan->next_index++;
+  edge_pos[root] = graph->offsets[root];
+  stack[top++] = root;
+  on_stack[root] = true;
+  call[depth++] = root;
+
+  while (depth > 0) {
+    int v = call[depth - 1];
+    int end = v == skip ? edge_pos[v] : graph->offsets[v + 1];
+
+    if (edge_pos[v] < end) {
+      int w = graph->targets[edge_pos[v]++];
+
+      if (index[w] < 0) {
+        // Descend
+        index[w] = low[w] = tarjan->next_index++;
+        edge_pos[w] = graph->offsets[w];
+        stack[top++] = w;
+        on_stack[w] = true;
+        call[depth++] = w;
+      } else if (on_stack[w] && index[w] < low[v]) {
+        low[v] = index[w];
+      }
+
+      continue;
+    }
+
+    // Every output done: return to the caller
+    depth--;
+    if (depth > 0 && low[v] < low[call[depth - 1]])
+      low[call[depth - 1]] = low[v];
+
+    if (low[v] != index[v])
+      continue;
+
+    // v roots a component, now on the stack from v upwards
+    int first = top;
+    do
+      on_stack[stack[--first]] = false;
+    while (stack[first] != v);
+
+    for (int i = first; i < top; i++) {
+      order[(*length)++] = stack[i];
+      component[stack[i]] = tarjan->num_components;
+    }
+
+    tarjan->num_components++;
+    top = first;
+  }
+}
+
+// Whether the component at order[first .. first + size) holds a cycle
+static inline bool component_cyclic(const Graph *graph, const int *order,
+                                    int first, int size, int skip) {
+  if (size > 1)
+    return true;
+
+  int v = order[first];
+
+  for (int e = graph->offsets[v]; v != skip && e < graph->offsets[v + 1]; e++)
+    if (graph->targets[e] == v)
+      return true;
+
+  return false;
+}
+
+// Devices reachable from source, in reverse topological order
+// Paths end at the target, so its outputs are never followed. Returns the
+// number of devices written to order, -1 if a cycle lies on some path from
+// source to target (after reporting every such component) and -2 if memory
+// runs out.
+static inline int path_order(const Graph *graph, int source, int target,
+                             int *order) {
+  int n = graph->num_nodes;
+  int *component = malloc((n ? n : 1) * sizeof(int));
+  bool *reaches = calloc(n ? n : 1, sizeof(bool)); // Can reach the target
+  Tarjan tarjan;
+  int length = 0, result = 0;
+
+  if (!component || !reaches || !tarjan_init(&tarjan, n)) {
+    free(component);
+    free(reaches);
+
+    return -2;
+  }
+
+  tarjan_visit(graph, &tarjan, source, target, order, &length, component);
+  tarjan_free(&tarjan);
+
+  // A component reaches the target through any output finished before it
+  for (int first = 0, size; first < length; first += size) {
+    int c = component[order[first]];
+    bool reach = false;
+
+    for (size = 0; first + size < length; size++) {
+      int u = order[first + size];
+
+      if (component[u] != c)
+        break;
+
+      reach |= u == target;
+      for (int e = graph->offsets[u]; u != target && e < graph->offsets[u + 1];
+           e++)
+        reach |= reaches[graph->targets[e]];
+    }
+
+    if (reach && component_cyclic(graph, order, first, size, target)) {
+      report_cycle(graph, order + first, size);
+      result = -1;
+    }
+
+    for (int i = first; i < first + size; i++)
+      reaches[order[i]] = reach;
+  }
+
+  free(component);
+  free(reaches);
+
+  return result < 0 ? result : length;
+}
+
+// Paths from every device in order to `to`, into count
+// A path that meets `stop` first ends there, so it never reaches `to`.
+// Counts start at zero, so an edge within a cycle that can't reach `to`
+// never picks up a stale value from an earlier pass.
+static inline void count_paths_to(const Graph *graph, const int *order,
+                                  int length, int to, int stop,
+                                  PathCount *count) {
+  for (int i = 0; i < length; i++)
+    count[order[i]] = 0;
+
+  for (int i = 0; i < length; i++) {
+    int v = order[i];
+    PathCount sum = 0;
+
+    if (v == to) {
+      sum = 1;
+    } else if (v != stop) {
+      for (int e = graph->offsets[v]; e < graph->offsets[v + 1]; e++)
+        sum += count[graph->targets[e]];
+    }
+
+    count[v] = sum;
+  }
+}
+
+// Every device in reverse topological order, with its component number
+// Returns 0 if memory runs out.
+static inline int graph_order(const Graph *graph, int *order, int *component) {
+  Tarjan tarjan;
+  int length = 0;
+
+  if (!tarjan_init(&tarjan, graph->num_nodes))
+    return 0;
+
+  for (int v = 0; v < graph->num_nodes; v++)
+    tarjan_visit(graph, &tarjan, v, -1, order, &length, component);
+
+  tarjan_free(&tarjan);
+
+  return 1;
+}
+
+// Paths from every device to target, into count, over a graph_order() order
+// tainted[v] marks devices with a cycle on some path to the target, whose
+// counts mean nothing; the count for any other device is exact.
+static inline void count_paths_to_all(const Graph *graph, const int *order,
+                                      const int *component, int target,
+                                      PathCount *count, bool *tainted) {
+  int n = graph->num_nodes;
+
+  for (int first = 0, size; first < n; first += size) {
+    int c = component[order[first]];
+    bool reach = false, cycle_below = false;
+
+    for (size = 0; first + size < n && component[order[first + size]] == c;
+         size++)
+      count[order[first + size]] = 0;
+
+    for (int i = first; i < first + size; i++) {
+      int u = order[i];
+      PathCount sum = 0;
+      bool taint = false;
+
+      if (u == target) {
+        sum = 1;
+      } else {
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+          int w = graph->targets[e];
+
+          sum += count[w];
+          taint |= component[w] != c && tainted[w];
+        }
+      }
+
+      count[u] = sum;
+      tainted[u] = taint;
+      reach |= sum > 0;
+      cycle_below |= taint;
+    }
+
+    // The target's own outputs are ignored, but a cycle through it still
+    // taints conservatively; callers fall back to an exact search
+    if ((reach || cycle_below) &&
+        component_cyclic(graph, order, first, size, target))
+      for (int i = first; i < first + size; i++)
+        tainted[order[i]] = true;
+  }
+}
+
+// Number of paths from source to target, into *paths
+// Returns 1 on success, -1 if a cycle lies on some path and 0 if memory runs
+// out.
+static inline int count_paths_dag(const Graph *graph, int source, int target,
+                                  PathCount *paths) {
+  int n = graph->num_nodes;
+  int *order = malloc((n ? n : 1) * sizeof(int));
+  PathCount *count = calloc(n ? n : 1, sizeof(PathCount));
+  int length = order && count ? path_order(graph, source, target, order) : -2;
+
+  *paths = 0;
+
+  if (length >= 0) {
+    count_paths_to(graph, order, length, target, target, count);
+    *paths = count[source];
+  }
+
+  free(order);
+  free(count);
+
+  return length >= 0 ? 1 : length == -1 ? -1 : 0;
+}
+
+// Paths over the devices in order, tracking which waypoints they pass
+// count[v * masks + m] is the number of paths from v to the target whose
+// waypoints, v's included, are exactly the set m. count starts zeroed.
+static inline void count_paths_masked(const Graph *graph, const int *order,
+                                      int length, int target,
+                                      const int *waypoint_bit, int num_masks,
+                                      PathCount *count) {
+  for (int i = 0; i < length; i++) {
+    int v = order[i];
+    int bit = waypoint_bit[v];
+    PathCount *own = count + (size_t)v * num_masks;
+
+    if (v == target) {
+      own[bit] = 1;
+      continue;
+    }
+
+    for (int e = graph->offsets[v]; e < graph->offsets[v + 1]; e++) {
+      const PathCount *next = count + (size_t)graph->targets[e] * num_masks;
+
+      for (int m = 0; m < num_masks; m++)
+        own[m | bit] += next[m];
+    }
+  }
+}
+
+// Number of paths from source to target passing every waypoint, into *paths
+// In a DAG the waypoints of a path appear in topological order, so the count
+// is the product of the path counts between consecutive waypoints in that
+// order: k + 1 linear passes. A single pass carrying a count per waypoint set
+// costs 2^k per edge instead, so it's used when that's no dearer. Returns 1
+// on success, -1 if a cycle lies on some path and 0 if memory runs out.
+static inline int count_paths_via(const Graph *graph, int source, int target,
+                                  const int *waypoints, int num_waypoints,
+                                  PathCount *paths) {
+  int n = graph->num_nodes;
+  int *order = malloc((n ? n : 1) * sizeof(int));
+  int *rank = malloc((n ? n : 1) * sizeof(int));
+  int length = order && rank ? path_order(graph, source, target, order) : -2;
+  int via[MAX_WAYPOINTS];
+  int k = 0;
+
+  *paths = 0;
+
+  if (length < 0) {
+    free(order);
+    free(rank);
+
+    return length == -1 ? -1 : 0;
+  }
+
+  for (int v = 0; v < n; v++)
+    rank[v] = -1;
+  for (int i = 0; i < length; i++)
+    rank[order[i]] = i;
+
+  // Distinct waypoints, nearest the source first; one the source can't
+  // reach means there are no such paths
+  for (int i = 0; i < num_waypoints; i++) {
+    int w = waypoints[i];
+    bool seen = false;
+
+    if (w < 0 || rank[w] < 0) {
+      free(order);
+      free(rank);
+
+      return 1;
+    }
+
+    for (int j = 0; j < k; j++)
+      seen |= via[j] == w;
+
+    if (seen)
+      continue;
+
+    int j = k++;
+    while (j > 0 && rank[via[j - 1]] < rank[w]) {
+      via[j] = via[j - 1];
+      j--;
+    }
+    via[j] = w;
+  }
+
+  int num_masks = 1 << k;
+  PathCount *count = NULL;
+
+  // Cost per edge: 2^k for the masked pass, k + 1 for the product
+  if (num_masks <= k + 1)
+    count = calloc((size_t)(n ? n : 1) * num_masks, sizeof(PathCount));
+
+  int ok = 1;
+
+  if (count) {
+    for (int v = 0; v < n; v++)
+      rank[v] = 0;
+    for (int j = 0; j < k; j++)
+      rank[via[j]] = 1 << j;
+
+    count_paths_masked(graph, order, length, target, rank, num_masks, count);
+    *paths = count[(size_t)source * num_masks + num_masks - 1];
+  } else {
+    count = malloc((n ? n : 1) * sizeof(PathCount));
+    ok = count != NULL;
+
+    // source -> via[0] -> ... -> via[k - 1] -> target
+    PathCount product = 1;
+
+    for (int j = 0; ok && j <= k && product; j++) {
+      int from = j == 0 ? source : via[j - 1];
+      int to = j == k ? target : via[j];
+
+      count_paths_to(graph, order, length, to, target, count);
+      product *= count[from];
+    }
+
+    *paths = product;
+  }
+
+  free(order);
+  free(rank);
+  free(count);
+
+  return ok;
+}
+
+#endif
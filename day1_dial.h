@@ -0,0 +1,418 @@
+/*
+ * Routine: Advent of Code--Day 1: Dial Kernels
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * A dial of modulus M turned by a distance d = Mq + r reaches 0 once for
+ * each of its q full turns wherever it starts, plus at most once more in
+ * its last r clicks. The kernels split every signed distance that way with
+ * a reciprocal multiply, q = (|d| * m) >> k, rather than a division. Then,
+ * from position p with t = p + r signed, the last clicks reach 0 if t >= M
+ * going right or if p > 0 and t <= 0 going left, and the new position is t
+ * wrapped once either way: compares and selects, with no branches.
+ *
+ * The hot moduli (100, 256 and 1000) get kernels with m and k as
+ * constants; any other modulus uses the same kernel with them computed at
+ * run time. The AVX2 kernels run eight slices of a chunk side by side, each
+ * from the position the slices before it leave the dial in. dial_rotate()
+ * is the plain scalar reference they are checked against.
+ *
+ * Rotation lines may start with a dial number, as in "2: R15" or "2 R15",
+ * so one log can drive several dials; lines without one turn dial 0.
+ */
+
+#ifndef DAY1_DIAL_H
+#define DAY1_DIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DIAL_HAVE_AVX2 1
+#endif
+
+#define DIAL_SIZE 100     // Default modulus
+#define DIAL_START 50     // Default starting position
+#define DIAL_MAX_SIZE (1 << 30)
+#define DIAL_LANES 8      // Slices per chunk in the AVX2 kernels
+#define MAX_DIALS 64
+
+#define DIAL_INLINE static inline __attribute__((always_inline))
+
+typedef struct {
+  int modulus, start;
+
+  // a / modulus == (a * multiplier) >> shift for any a < 2^31
+  uint64_t multiplier;
+  int shift;
+} Dial;
+
+// One dial's rotations within one chunk of the log
+typedef struct {
+  int32_t *deltas; // Signed distances, one per rotation
+  size_t count, capacity;
+  long long turns; // Full turns taken off distances too long to store
+  long long net;   // Sum of deltas
+  int start;       // Position before the chunk, once the log is scanned
+} DialChunk;
+
+// Set up a dial, return 0 unless 1 <= modulus <= DIAL_MAX_SIZE
+// With l = ceil(log2 modulus), k = 31 + l and m = 2^k / modulus + 1 make m *
+// modulus - 2^k at most 2^l, so the product's error never reaches the next
+// multiple of 2^k for 31-bit a.
+static inline int dial_init(Dial *dial, int modulus, int start) {
+  if (modulus < 1 || modulus > DIAL_MAX_SIZE)
+    return 0;
+
+  int l = 0;
+  while ((1LL << l) < modulus)
+    l++;
+
+  dial->modulus = modulus;
+  dial->start = ((start % modulus) + modulus) % modulus;
+  dial->shift = 31 + l;
+  dial->multiplier = ((uint64_t)1 << dial->shift) / modulus + 1;
+
+  return 1;
+}
+
+// floor(c / modulus), rounding down for negative c too
+static inline long long dial_floor(long long c, int modulus) {
+  return c >= 0 ? c / modulus : -((modulus - 1 - c) / modulus);
+}
+
+// Turn a dial at *position once, return the times it reaches 0
+// The reference the kernels are checked against, as the puzzle states it.
+static inline long long dial_rotate(int *position, char direction,
+                                    long long distance, int modulus) {
+  long long zeros;
+
+  if (direction == 'R') {
+    zeros = dial_floor(*position + distance, modulus);
+    *position = (int)((*position + distance) % modulus);
+  } else {
+    zeros = dial_floor(*position - 1, modulus) -
+            dial_floor(*position - distance - 1, modulus);
+    *position = (int)(((*position - distance) % modulus + modulus) % modulus);
+  }
+
+  return zeros;
+}
+
+// Parse one rotation at *p, up to end, and leave *p at the next line
+// Returns 0 for a line that isn't a rotation.
+static inline int dial_parse(const char **p, const char *end, int *dial,
+                             char *direction, long long *distance) {
+  const char *s = *p;
+  int number = 0, ok = 0;
+  long long value = 0;
+
+  while (s < end && (*s == ' ' || *s == '\t' || *s == '\r'))
+    s++;
+
+  // Optional dial number
+  for (; s < end && *s >= '0' && *s <= '9'; s++)
+    if (number <= MAX_DIALS)
+      number = number * 10 + (*s - '0');
+
+  while (s < end && (*s == ':' || *s == ' ' || *s == '\t'))
+    s++;
+
+  if (s < end && (*s == 'L' || *s == 'R')) {
+    *direction = *s++;
+
+    while (s < end && (*s == ' ' || *s == '\t'))
+      s++;
+
+    for (; s < end && *s >= '0' && *s <= '9'; s++) {
+      value = value * 10 + (*s - '0');
+      ok = 1;
+    }
+  }
+
+  while (s < end && *s != '\n')
+    s++;
+
+  *p = s < end ? s + 1 : end;
+  *dial = number;
+  *distance = value;
+
+  return ok;
+}
+
+// Append a signed distance, return 0 if memory runs out
+static inline int dial_push(DialChunk *chunk, const Dial *dial, char direction,
+                            long long distance) {
+  // Distances past 31 bits shed their full turns here, the slow way
+  if (distance > INT32_MAX) {
+    chunk->turns += distance / dial->modulus;
+    distance %= dial->modulus;
+  }
+
+  if (chunk->count == chunk->capacity) {
+    size_t capacity = chunk->capacity ? chunk->capacity * 2 : 1024;
+    int32_t *grown = realloc(chunk->deltas, capacity * sizeof(int32_t));
+
+    if (!grown)
+      return 0;
+    chunk->deltas = grown;
+    chunk->capacity = capacity;
+  }
+
+  int32_t delta = (int32_t)(direction == 'R' ? distance : -distance);
+
+  chunk->deltas[chunk->count++] = delta;
+  chunk->net += delta;
+
+  return 1;
+}
+
+// Parse the rotations on the lines that start in text[begin .. end) into
+// one DialChunk per dial
+// text is size bytes long; a line may run past end to finish. Lines naming
+// a dial that doesn't exist are skipped. Returns 0 if memory runs out.
+static inline int dial_parse_chunk(const char *text, size_t size, size_t begin,
+                                   size_t end, const Dial *dials,
+                                   int num_dials, DialChunk *chunks) {
+  const char *p = text + begin, *stop = text + end, *limit = text + size;
+
+  // Every rotation takes at least two bytes, so a lone dial never grows
+  if (num_dials == 1) {
+    chunks[0].capacity = (end - begin) / 2 + 1;
+    chunks[0].deltas = malloc(chunks[0].capacity * sizeof(int32_t));
+    if (!chunks[0].deltas)
+      return 0;
+  }
+
+  // Start at the first whole line
+  if (begin > 0 && text[begin - 1] != '\n') {
+    while (p < limit && *p != '\n')
+      p++;
+    if (p < limit)
+      p++;
+  }
+
+  while (p < stop) {
+    int dial;
+    char direction;
+    long long distance;
+
+    if (!dial_parse(&p, limit, &dial, &direction, &distance) ||
+        dial >= num_dials)
+      continue;
+
+    if (!dial_push(&chunks[dial], &dials[dial], direction, distance))
+      return 0;
+  }
+
+  return 1;
+}
+
+// Net rotation of a chunk, mod the dial's modulus
+static inline int dial_offset(const DialChunk *chunk, const Dial *dial) {
+  return (int)(((chunk->net % dial->modulus) + dial->modulus) %
+               dial->modulus);
+}
+
+// Branchless scalar kernel: zeros reached by count deltas from *position
+DIAL_INLINE long long dial_kernel(const int32_t *deltas, size_t count,
+                                  int *position, int modulus,
+                                  uint64_t multiplier, int shift) {
+  int p = *position;
+  long long zeros = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    int32_t sign = deltas[i] >> 31; // 0 or -1
+    uint32_t a = (uint32_t)((deltas[i] ^ sign) - sign);
+    uint32_t q = (uint32_t)((a * multiplier) >> shift);
+    int32_t r = (int32_t)(a - q * (uint32_t)modulus);
+    int t = p + ((r ^ sign) - sign);
+
+    zeros += q + ((t >= modulus) | ((t <= 0) & (p > 0)));
+    p = t + modulus * ((t < 0) - (t >= modulus));
+  }
+
+  *position = p;
+
+  return zeros;
+}
+
+#ifdef DIAL_HAVE_AVX2
+// The scalar kernel on DIAL_LANES slices at once, one per 32-bit lane
+// Needs multiplier < 2^32, since the multiplies take 32-bit operands.
+__attribute__((target("avx2"))) DIAL_INLINE long long
+dial_kernel_avx2(const int32_t *deltas, size_t count, int *position,
+                 int modulus, uint64_t multiplier, int shift) {
+  size_t slice = count / DIAL_LANES;
+
+  if (slice == 0 || count > INT32_MAX)
+    return dial_kernel(deltas, count, position, modulus, multiplier, shift);
+
+  // Each slice starts where the ones before it leave the dial
+  int starts[DIAL_LANES], base[DIAL_LANES];
+  int p = *position;
+
+  for (int l = 0; l < DIAL_LANES; l++) {
+    long long net = 0;
+
+    for (size_t i = l * slice; i < (l + 1) * slice; i++)
+      net += deltas[i];
+
+    starts[l] = p;
+    base[l] = (int)(l * slice);
+    p = (int)(((p + net) % modulus + modulus) % modulus);
+  }
+
+  __m256i pos = _mm256_loadu_si256((const __m256i *)starts);
+  __m256i index = _mm256_loadu_si256((const __m256i *)base);
+  __m256i one = _mm256_set1_epi32(1), zero = _mm256_setzero_si256();
+  __m256i size = _mm256_set1_epi32(modulus);
+  __m256i top = _mm256_set1_epi32(modulus - 1);
+  __m256i mult = _mm256_set1_epi64x((long long)multiplier);
+  __m128i bits = _mm_cvtsi32_si128(shift);
+  __m256i hits = zero, turns_even = zero, turns_odd = zero;
+
+  for (size_t i = 0; i < slice; i++) {
+    __m256i delta = _mm256_i32gather_epi32((const int *)deltas, index, 4);
+    __m256i sign = _mm256_srai_epi32(delta, 31);
+    __m256i a = _mm256_sub_epi32(_mm256_xor_si256(delta, sign), sign);
+
+    // q = (a * m) >> k, on the even lanes and then the odd ones
+    __m256i q_even = _mm256_srl_epi64(_mm256_mul_epu32(a, mult), bits);
+    __m256i q_odd = _mm256_srl_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(a, 32), mult), bits);
+    __m256i q = _mm256_or_si256(q_even, _mm256_slli_epi64(q_odd, 32));
+
+    __m256i r = _mm256_sub_epi32(a, _mm256_mullo_epi32(q, size));
+    __m256i t = _mm256_add_epi32(
+        pos, _mm256_sub_epi32(_mm256_xor_si256(r, sign), sign));
+
+    __m256i over = _mm256_cmpgt_epi32(t, top);   // t >= modulus
+    __m256i under = _mm256_cmpgt_epi32(zero, t); // t < 0
+    __m256i landed = _mm256_and_si256(_mm256_cmpgt_epi32(one, t),
+                                      _mm256_cmpgt_epi32(pos, zero));
+
+    // Masks are -1, so subtracting counts them
+    hits = _mm256_sub_epi32(hits, _mm256_or_si256(over, landed));
+    turns_even = _mm256_add_epi64(turns_even, q_even);
+    turns_odd = _mm256_add_epi64(turns_odd, q_odd);
+    pos = _mm256_add_epi32(t, _mm256_and_si256(under, size));
+    pos = _mm256_sub_epi32(pos, _mm256_and_si256(over, size));
+    index = _mm256_add_epi32(index, one);
+  }
+
+  int lanes[DIAL_LANES];
+  long long wide[4];
+  long long zeros = 0;
+
+  _mm256_storeu_si256((__m256i *)lanes, hits);
+  for (int l = 0; l < DIAL_LANES; l++)
+    zeros += lanes[l];
+
+  _mm256_storeu_si256((__m256i *)wide,
+                      _mm256_add_epi64(turns_even, turns_odd));
+  for (int l = 0; l < 4; l++)
+    zeros += wide[l];
+
+  // What's left after the last slice
+  *position = p;
+
+  return zeros + dial_kernel(deltas + DIAL_LANES * slice,
+                             count - DIAL_LANES * slice, position, modulus,
+                             multiplier, shift);
+}
+
+#define DIAL_AVX2_KERNEL(M, SHIFT)                                             \
+  __attribute__((target("avx2"))) static inline long long dial_run_avx2_##M(   \
+      const int32_t *deltas, size_t count, int *position) {                   \
+    return dial_kernel_avx2(deltas, count, position, M,                        \
+                            ((uint64_t)1 << SHIFT) / M + 1, SHIFT);            \
+  }
+#else
+#define DIAL_AVX2_KERNEL(M, SHIFT)
+#endif
+
+// Kernels for a modulus known at compile time; SHIFT is 31 + ceil(log2 M)
+#define DEFINE_DIAL_KERNELS(M, SHIFT)                                          \
+  static inline long long dial_run_##M(const int32_t *deltas, size_t count,    \
+                                       int *position) {                        \
+    return dial_kernel(deltas, count, position, M,                             \
+                       ((uint64_t)1 << SHIFT) / M + 1, SHIFT);                 \
+  }                                                                            \
+  DIAL_AVX2_KERNEL(M, SHIFT)
+
+DEFINE_DIAL_KERNELS(100, 38)
+DEFINE_DIAL_KERNELS(256, 39)
+DEFINE_DIAL_KERNELS(1000, 41)
+
+static inline long long dial_run_any(const int32_t *deltas, size_t count,
+                                     int *position, const Dial *dial) {
+  return dial_kernel(deltas, count, position, dial->modulus, dial->multiplier,
+                     dial->shift);
+}
+
+#ifdef DIAL_HAVE_AVX2
+__attribute__((target("avx2"))) static inline long long
+dial_run_avx2_any(const int32_t *deltas, size_t count, int *position,
+                  const Dial *dial) {
+  return dial_kernel_avx2(deltas, count, position, dial->modulus,
+                          dial->multiplier, dial->shift);
+}
+#endif
+
+// Zeros reached by one dial's chunk from chunk->start, on the fastest kernel
+static inline long long dial_run_chunk(const DialChunk *chunk,
+                                       const Dial *dial) {
+  const int32_t *deltas = chunk->deltas;
+  size_t count = chunk->count;
+  int position = chunk->start;
+
+#ifdef DIAL_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    switch (dial->modulus) {
+    case 100:
+      return chunk->turns + dial_run_avx2_100(deltas, count, &position);
+    case 256:
+      return chunk->turns + dial_run_avx2_256(deltas, count, &position);
+    case 1000:
+      return chunk->turns + dial_run_avx2_1000(deltas, count, &position);
+    }
+
+    if (dial->multiplier <= UINT32_MAX)
+      return chunk->turns + dial_run_avx2_any(deltas, count, &position, dial);
+  }
+#endif
+
+  switch (dial->modulus) {
+  case 100:
+    return chunk->turns + dial_run_100(deltas, count, &position);
+  case 256:
+    return chunk->turns + dial_run_256(deltas, count, &position);
+  case 1000:
+    return chunk->turns + dial_run_1000(deltas, count, &position);
+  }
+
+  return chunk->turns + dial_run_any(deltas, count, &position, dial);
+}
+
+// The same through the reference, one rotation at a time
+static inline long long dial_check_chunk(const DialChunk *chunk,
+                                         const Dial *dial) {
+  int position = chunk->start;
+  long long zeros = chunk->turns;
+
+  for (size_t i = 0; i < chunk->count; i++) {
+    long long delta = chunk->deltas[i];
+
+    zeros += dial_rotate(&position, delta < 0 ? 'L' : 'R',
+                         delta < 0 ? -delta : delta, dial->modulus);
+  }
+
+  return zeros;
+}
+
+#endif
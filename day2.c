@@ -5,35 +5,104 @@
  *
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  */
+
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "input_cache.h"
+#include "result_cache.h"
+
+#define DAY2_INPUT_KIND INPUT_CACHE_KIND(2, 1)
+#define DAY2_RESULT_VERSION 1
+
+struct Range {
+  long long start;
+  long long end;
+};
+
 // Prototypes
 int is_invalid_id(long long id);
+int parse_ranges(FILE *fp, struct Range **ranges);
 
 int main() {
+  ResultCache results;
+  if (result_cache_open(&results, "day2_input.txt", 2, 1, DAY2_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
   long long total_sum = 0;
 
-  FILE *fp = fopen("day2_input.txt", "r");
-  if (fp == NULL) {
+  InputCache input;
+  if (!input_cache_open(&input, "day2_input.txt", DAY2_INPUT_KIND, 0)) {
     fprintf(stderr, "Error: Could not open input file\n");
 
     return 1;
   }
 
+  // The ranges come straight from the cache file when it has them
+  const struct Range *ranges;
+  struct Range *parsed = NULL;
+  size_t bytes;
+  int num_ranges;
+
+  if (input_cache_hit(&input)) {
+    ranges = input_cache_section(&input, 0, &bytes);
+    num_ranges = (int)(bytes / sizeof(struct Range));
+  } else {
+    FILE *fp = input_cache_fopen(&input);
+    if (fp == NULL) {
+      fprintf(stderr, "Error: Could not open input file\n");
+
+      return 1;
+    }
+
+    num_ranges = parse_ranges(fp, &parsed);
+
+    fclose(fp);
+
+    if (num_ranges < 0)
+      return 1;
+
+    const void *sections[] = {parsed};
+
+    bytes = num_ranges * sizeof(struct Range);
+    input_cache_store(&input, 1, sections, &bytes);
+    ranges = parsed;
+  }
+
+  for (int i = 0; i < num_ranges; i++) {
+    // Check each ID in the range for validity
+    for (long long id = ranges[i].start; id <= ranges[i].end; id++) {
+      if (is_invalid_id(id))
+        total_sum += id;
+    }
+  }
+
+  free(parsed);
+  input_cache_close(&input);
+
+  result_printf(&results, "Sum of invalid IDs: %lld\n", total_sum);
+  result_cache_finish(&results);
+
+  return 0;
+}
+
+// Read the comma-separated ranges into a growable array
+// Returns the number of ranges, or -1 on failure
+int parse_ranges(FILE *fp, struct Range **ranges) {
   // Read the entire line (it's one line, and it's long as fuck)
-  char line[1000000]; // Big glizzy buffer
+  static char line[1000000]; // Big glizzy buffer
 
   if (fgets(line, sizeof(line), fp) == NULL) {
     fprintf(stderr, "Error: Could not read input\n");
 
-    fclose(fp);
-
-    return 1;
+    return -1;
   }
 
-  fclose(fp);
+  int count = 0, capacity = 0;
 
   // Parse each range separated by comma
   char *token = strtok(line, ",");
@@ -42,19 +111,27 @@ int main() {
     long long start, end;
 
     if (sscanf(token, "%lld-%lld", &start, &end) == 2) {
-      // Check each ID in the range for validity
-      for (long long id = start; id <= end; id++) {
-        if (is_invalid_id(id))
-          total_sum += id;
+      if (count == capacity) {
+        capacity = capacity ? capacity * 2 : 64;
+        struct Range *grown = realloc(*ranges, capacity * sizeof(struct Range));
+
+        if (!grown) {
+          fprintf(stderr, "Error: Memory allocation failed\n");
+
+          return -1;
+        }
+        *ranges = grown;
       }
+
+      ranges[0][count].start = start;
+      ranges[0][count].end = end;
+      count++;
     }
 
     token = strtok(NULL, ",");
   }
 
-  printf("Sum of invalid IDs: %lld\n", total_sum);
-
-  return 0;
+  return count;
 }
 
 int is_invalid_id(long long id) {
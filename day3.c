@@ -6,14 +6,25 @@
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "result_cache.h"
+
+#define DAY3_RESULT_VERSION 1
+
 // Prototype
 long long find_max_joltage(char *line);
 
 int main() {
+  ResultCache results;
+  if (result_cache_open(&results, "day3_input.txt", 3, 1, DAY3_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
   FILE *fp = fopen("day3_input.txt", "r");
   if (fp == NULL) {
     fprintf(stderr, "Error: Could not open input file\n");
@@ -33,7 +44,8 @@ int main() {
 
   fclose(fp);
 
-  printf("Total output joltage: %lld\n", total_sum);
+  result_printf(&results, "Total output joltage: %lld\n", total_sum);
+  result_cache_finish(&results);
 
   return 0;
 }
@@ -6,51 +6,52 @@
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "input_cache.h"
+#include "result_cache.h"
+
+#define DAY4_INPUT_KIND INPUT_CACHE_KIND(4, 1)
+#define DAY4_RESULT_VERSION 1
+
+// Prototype
+int read_grid(InputCache *input, char grid[][1000]);
+
 int main() {
-  FILE *fp = fopen("day4_input.txt", "r");
-  if (fp == NULL) {
+  ResultCache results;
+  if (result_cache_open(&results, "day4_input.txt", 4, 1, DAY4_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
+  InputCache input;
+  if (!input_cache_open(&input, "day4_input.txt", DAY4_INPUT_KIND, 0)) {
     fprintf(stderr, "Error: Could not open input file\n");
 
     return 1;
   }
 
-  // Read the grid into 2D char array
+  // Read the grid into 2D char array, already trimmed if it's cached
   char grid[1000][1000];
-  int rows = 0;
+  int rows = -1;
 
-  while (fgets(grid[rows], sizeof(grid[rows]), fp)) {
-    int len = strlen(grid[rows]);
-    // Trim newline
-    if (len > 0 && grid[rows][len - 1] == '\n') {
-      grid[rows][len - 1] = '\0';
+  if (input_cache_hit(&input))
+    rows = input_cache_load_grid(&input, grid[0], sizeof(grid[0]), 1000, NULL);
 
-      len--;
-    }
+  if (rows < 0)
+    rows = read_grid(&input, grid);
 
-    // Trim trailing spaces
-    while (len > 0 && grid[rows][len - 1] == ' ') {
-      grid[rows][len - 1] = '\0';
+  input_cache_close(&input);
 
-      len--;
-    }
-
-    // Skip leading spaces by shifting the string
-    char *start = grid[rows];
-    while (*start == ' ')
-      start++;
-
-    if (start != grid[rows])
-      memmove(grid[rows], start, strlen(start) + 1);
+  if (rows < 0) {
+    fprintf(stderr, "Error: Could not open input file\n");
 
-    rows++;
+    return 1;
   }
 
-  fclose(fp);
-
   // 8 directions(all adjacent): N, NE, E, SE, S, SW, W, NW
   int dr[] = {-1, -1, 0, 1, 1, 1, 0, -1}; // Row
   int dc[] = {0, 1, 1, 1, 0, -1, -1, -1}; // Column
@@ -103,7 +104,51 @@ int main() {
 
   } while (current_removed > 0);
 
-  printf("Total removed: %d\n", total_removed);
+  result_printf(&results, "Total removed: %d\n", total_removed);
+  result_cache_finish(&results);
 
   return 0;
 }
+
+// Read the grid from the input, trimming each row, and cache it
+// Returns the number of rows, or -1 if the input can't be read
+int read_grid(InputCache *input, char grid[][1000]) {
+  FILE *fp = input_cache_fopen(input);
+  if (fp == NULL)
+    return -1;
+
+  int rows = 0;
+
+  while (fgets(grid[rows], sizeof(grid[rows]), fp)) {
+    int len = strlen(grid[rows]);
+    // Trim newline
+    if (len > 0 && grid[rows][len - 1] == '\n') {
+      grid[rows][len - 1] = '\0';
+
+      len--;
+    }
+
+    // Trim trailing spaces
+    while (len > 0 && grid[rows][len - 1] == ' ') {
+      grid[rows][len - 1] = '\0';
+
+      len--;
+    }
+
+    // Skip leading spaces by shifting the string
+    char *start = grid[rows];
+    while (*start == ' ')
+      start++;
+
+    if (start != grid[rows])
+      memmove(grid[rows], start, strlen(start) + 1);
+
+    rows++;
+  }
+
+  fclose(fp);
+
+  input_cache_store_grid(input, grid[0], sizeof(grid[0]), rows);
+
+  return rows;
+}
@@ -6,50 +6,77 @@
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "input_cache.h"
+#include "result_cache.h"
+
+#define DAY5_INPUT_KIND INPUT_CACHE_KIND(5, 1)
+#define DAY5_RESULT_VERSION 1
+
 // Create a simple start to end structure
 struct Range {
   long long start;
   long long end;
 };
 
-// Prototype
+// Prototypes
 int range_compare(const void *a, const void *b);
+int read_ranges(FILE *fp, struct Range *ranges);
 
 int main() {
-  FILE *fp = fopen("day5_input.txt", "r");
-  if (fp == NULL) {
+  ResultCache results;
+  if (result_cache_open(&results, "day5_input.txt", 5, 1, DAY5_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
+  InputCache input;
+  if (!input_cache_open(&input, "day5_input.txt", DAY5_INPUT_KIND, 0)) {
     fprintf(stderr, "Error: Could not open input file\n");
 
     return 1;
   }
 
-  // Read ranges until blank line
-  struct Range ranges[1000];
+  // The cache file keeps the ranges already sorted
+  struct Range parsed[1000];
+  const struct Range *ranges = parsed;
   int num_ranges = 0;
-  char line[256];
+  size_t bytes;
 
-  while (fgets(line, sizeof(line), fp)) {
-    // Check for blank line (separator)
-    if (line[0] == '\n' || line[0] == '\r')
-      break;
-    // Get the ranges
-    long long start, end;
-    if (sscanf(line, "%lld-%lld", &start, &end) == 2) {
-      ranges[num_ranges].start = start;
-      ranges[num_ranges].end = end;
+  if (input_cache_hit(&input)) {
+    ranges = input_cache_section(&input, 0, &bytes);
+    num_ranges = (int)(bytes / sizeof(struct Range));
 
-      num_ranges++;
+    if (num_ranges > 1000) {
+      input_cache_reject(&input);
+      ranges = parsed;
     }
   }
 
-  fclose(fp);
+  if (!input_cache_hit(&input)) {
+    FILE *fp = input_cache_fopen(&input);
+    if (fp == NULL) {
+      fprintf(stderr, "Error: Could not open input file\n");
+
+      return 1;
+    }
+
+    num_ranges = read_ranges(fp, parsed);
+
+    fclose(fp);
+
+    // Sort ranges by start point
+    qsort(parsed, num_ranges, sizeof(struct Range), range_compare);
+
+    const void *sections[] = {parsed};
 
-  // Sort ranges by start point
-  qsort(ranges, num_ranges, sizeof(struct Range), range_compare);
+    bytes = num_ranges * sizeof(struct Range);
+    input_cache_store(&input, 1, sections, &bytes);
+  }
 
   // Merge overlapping ranges
   struct Range merged[1000];
@@ -60,7 +87,7 @@ int main() {
 
   for (int i = 1; i < num_ranges; i++) {
     struct Range *last = &merged[num_merged - 1];
-    struct Range *current = &ranges[i];
+    const struct Range *current = &ranges[i];
 
     // Check if current overlaps with last merged range
     if (current->start <= last->end + 1) {
@@ -75,6 +102,8 @@ int main() {
     }
   }
 
+  input_cache_close(&input);
+
   // Count total IDs in merged ranges
   long long total_count = 0;
 
@@ -84,11 +113,34 @@ int main() {
     total_count += count;
   }
 
-  printf("Total fresh ingredient IDs: %lld\n", total_count);
+  result_printf(&results, "Total fresh ingredient IDs: %lld\n", total_count);
+  result_cache_finish(&results);
 
   return 0;
 }
 
+// Read ranges until blank line, return how many
+int read_ranges(FILE *fp, struct Range *ranges) {
+  int num_ranges = 0;
+  char line[256];
+
+  while (fgets(line, sizeof(line), fp)) {
+    // Check for blank line (separator)
+    if (line[0] == '\n' || line[0] == '\r')
+      break;
+    // Get the ranges
+    long long start, end;
+    if (sscanf(line, "%lld-%lld", &start, &end) == 2) {
+      ranges[num_ranges].start = start;
+      ranges[num_ranges].end = end;
+
+      num_ranges++;
+    }
+  }
+
+  return num_ranges;
+}
+
 // Comparison function for qsort
 int range_compare(const void *a, const void *b) {
   struct Range *r1 = (struct Range *)a;
@@ -6,12 +6,23 @@
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "result_cache.h"
+
+#define DAY6_RESULT_VERSION 1
+
 int main() {
+  ResultCache results;
+  if (result_cache_open(&results, "day6_input.txt", 6, 1, DAY6_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
   FILE *fp = fopen("day6_input.txt", "r");
   if (fp == NULL) {
     fprintf(stderr, "Error: Could not open input file\n");
@@ -122,7 +133,8 @@ int main() {
     }
   }
 
-  printf("Grand total: %lld\n", grand_total);
+  result_printf(&results, "Grand total: %lld\n", grand_total);
+  result_cache_finish(&results);
 
   return 0;
 }
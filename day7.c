@@ -6,11 +6,18 @@
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "input_cache.h"
+#include "result_cache.h"
+
 #define MAX_BEAMS 100000
+#define DAY7_INPUT_KIND INPUT_CACHE_KIND(7, 1)
+#define DAY7_RESULT_VERSION 1
 
 // Create a structure for the Tachyon Beam
 struct Beam {
@@ -18,9 +25,17 @@ struct Beam {
   int row;
 };
 
+// Prototype
+int read_grid(InputCache *input, char grid[][1000], int *cols);
+
 int main() {
-  FILE *fp = fopen("day7_input.txt", "r");
-  if (fp == NULL) {
+  ResultCache results;
+  if (result_cache_open(&results, "day7_input.txt", 7, 1, DAY7_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
+  InputCache input;
+  if (!input_cache_open(&input, "day7_input.txt", DAY7_INPUT_KIND, 0)) {
     fprintf(stderr, "Error: Could not open input file\n");
 
     return 1;
@@ -28,24 +43,22 @@ int main() {
 
   // Read the grid
   static char grid[1000][1000];
-  int rows = 0;
+  int rows = -1;
   int cols = 0;
 
-  while (fgets(grid[rows], sizeof(grid[rows]), fp)) {
-    int len = strlen(grid[rows]);
+  if (input_cache_hit(&input))
+    rows = input_cache_load_grid(&input, grid[0], sizeof(grid[0]), 1000, &cols);
 
-    if (len > 0 && grid[rows][len - 1] == '\n') {
-      grid[rows][len - 1] = '\0';
+  if (rows < 0)
+    rows = read_grid(&input, grid, &cols);
 
-      len--;
-    }
-    if (len > cols)
-      cols = len;
+  input_cache_close(&input);
 
-    rows++;
-  }
+  if (rows < 0) {
+    fprintf(stderr, "Error: Could not open input file\n");
 
-  fclose(fp);
+    return 1;
+  }
 
   // Find the beam entry point: S
   int start_col = -1, start_row = -1;
@@ -127,7 +140,38 @@ int main() {
     }
   }
 
-  printf("Total splits: %d\n", split_count);
+  result_printf(&results, "Total splits: %d\n", split_count);
+  result_cache_finish(&results);
 
   return 0;
 }
+
+// Read the grid from the input and cache it
+// Returns the number of rows, or -1 if the input can't be read
+int read_grid(InputCache *input, char grid[][1000], int *cols) {
+  FILE *fp = input_cache_fopen(input);
+  if (fp == NULL)
+    return -1;
+
+  int rows = 0;
+
+  while (fgets(grid[rows], sizeof(grid[rows]), fp)) {
+    int len = strlen(grid[rows]);
+
+    if (len > 0 && grid[rows][len - 1] == '\n') {
+      grid[rows][len - 1] = '\0';
+
+      len--;
+    }
+    if (len > *cols)
+      *cols = len;
+
+    rows++;
+  }
+
+  fclose(fp);
+
+  input_cache_store_grid(input, grid[0], sizeof(grid[0]), rows);
+
+  return rows;
+}
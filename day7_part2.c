@@ -6,42 +6,56 @@
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "input_cache.h"
+#include "result_cache.h"
+
 static char grid[1000][1000];
 static int rows = 0;
 static int cols = 0;
 static long long memo[1000][1000]; // Memoization cache (-1 = not computed)
 
-// Prototype
+#define DAY7_INPUT_KIND INPUT_CACHE_KIND(7, 1)
+#define DAY7_RESULT_VERSION 1
+
+// Prototypes
 long long count_timelines(int col, int row);
+int read_grid(InputCache *input);
 
 int main() {
-  FILE *fp = fopen("day7_input.txt", "r");
-  if (fp == NULL) {
+  ResultCache results;
+  if (result_cache_open(&results, "day7_input.txt", 7, 2, DAY7_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
+  InputCache input;
+  if (!input_cache_open(&input, "day7_input.txt", DAY7_INPUT_KIND, 0)) {
     fprintf(stderr, "Error: Could not open input file\n");
 
     return 1;
   }
 
   // Read the grid
-  while (fgets(grid[rows], sizeof(grid[rows]), fp)) {
-    int len = strlen(grid[rows]);
+  rows = -1;
 
-    if (len > 0 && grid[rows][len - 1] == '\n') {
-      grid[rows][len - 1] = '\0';
+  if (input_cache_hit(&input))
+    rows = input_cache_load_grid(&input, grid[0], sizeof(grid[0]), 1000, &cols);
 
-      len--;
-    }
-    if (len > cols)
-      cols = len;
+  if (rows < 0)
+    rows = read_grid(&input);
 
-    rows++;
-  }
+  input_cache_close(&input);
 
-  fclose(fp);
+  if (rows < 0) {
+    fprintf(stderr, "Error: Could not open input file\n");
+
+    return 1;
+  }
 
   // Init memoization cache
   memset(memo, -1, sizeof(memo));
@@ -64,7 +78,8 @@ int main() {
   // Count all timelines starting from S
   long long timeline_count = count_timelines(start_col, start_row);
 
-  printf("Total timelines: %lld\n", timeline_count);
+  result_printf(&results, "Total timelines: %lld\n", timeline_count);
+  result_cache_finish(&results);
 
   return 0;
 }
@@ -114,3 +129,34 @@ long long count_timelines(int col, int row) {
 
   return result;
 }
+
+// Read the grid from the input and cache it
+// Returns the number of rows, or -1 if the input can't be read
+int read_grid(InputCache *input) {
+  FILE *fp = input_cache_fopen(input);
+  if (fp == NULL)
+    return -1;
+
+  rows = 0;
+  cols = 0;
+
+  while (fgets(grid[rows], sizeof(grid[rows]), fp)) {
+    int len = strlen(grid[rows]);
+
+    if (len > 0 && grid[rows][len - 1] == '\n') {
+      grid[rows][len - 1] = '\0';
+
+      len--;
+    }
+    if (len > cols)
+      cols = len;
+
+    rows++;
+  }
+
+  fclose(fp);
+
+  input_cache_store_grid(input, grid[0], sizeof(grid[0]), rows);
+
+  return rows;
+}
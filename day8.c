@@ -4,167 +4,576 @@
  * Author: DannyBimma
  *
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * To compile: gcc -std=c11 -O2 day8.c -lm -pthread -o day8
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_BOXES 1000
-#define MAX_PAIRS 500000
-
-// Create a structure for the junction boxes
-typedef struct {
-  int x, y, z;
-} Box;
+#include "day8_kdtree.h"
+#include "input_cache.h"
+#include "result_cache.h"
+#include "union_find.h"
+#include "work_pool.h"
+
+#define NUM_CONNECTIONS 1000
+#define RADIX_BITS 11
+#define RADIX_INDEX_DIGITS 3 // Digits in a 32-bit box index
+#define RADIX_DIST_DIGITS 6  // Digits in a 64-bit squared distance
+#define RADIX_DIGITS (2 * RADIX_INDEX_DIGITS + RADIX_DIST_DIGITS)
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_MIN_PER_THREAD 65536
+#define QUERY_BLOCK 256 // Tree positions a worker claims at a time
+#define DAY8_INPUT_KIND INPUT_CACHE_KIND(8, 1)
+#define DAY8_RESULT_VERSION 1
 
 // Create a structure for connected pairs of junction boxes
+// Keyed by the exact squared distance: ordering never needs the sqrt
 typedef struct {
-  int box1, box2;
-  double distance;
+  uint64_t dist2;
+  uint32_t box1, box2;
 } Pair;
 
+// One thread's slice of a radix sort pass
+typedef struct {
+  const Pair *src;
+  Pair *dst;
+  size_t begin, end;
+  int digit;
+  size_t hist[RADIX_BUCKETS]; // Bucket counts, then scatter offsets
+} RadixSlice;
+
+// Growable list of candidate pairs
+typedef struct {
+  Pair *items;
+  size_t count;
+  size_t capacity;
+} PairList;
+
+// One thread's share of the candidate pair search
+typedef struct {
+  const KdTree *tree;
+  uint64_t max_dist2;
+  PairList list;
+  atomic_int *next_block;
+  atomic_size_t *total; // Pairs found by all workers together
+  size_t cap;
+  size_t keep; // If set, the list is a max-heap of the keep smallest pairs
+  int overflow; // Stopped because the workers found more than cap pairs
+  int failed;
+} CollectWorker;
+
 // Declare initial data
-Box boxes[MAX_BOXES];
-Pair pairs[MAX_PAIRS];
-int parent[MAX_BOXES];
-int rank_arr[MAX_BOXES];
+Boxes boxes = {NULL, NULL, NULL, 0, 0};
 int num_boxes = 0;
+InputCache input; // Holds the coordinates when they come from its cache file
 
 // Prototypes
-void init_union_find(int n);
-int find(int x);
-void union_sets(int x, int y);
-double calc_distance(Box *a, Box *b);
-int compare_pairs(const void *a, const void *b);
+int radix_sort_pairs(Pair *pairs, size_t count);
+int read_boxes(const char *filename);
+int boxes_fit(void);
+int closest_pairs(const KdTree *tree, size_t k, PairList *list);
 
 int main() {
+  ResultCache results;
+  if (result_cache_open(&results, "day8_input.txt", 8, 1, DAY8_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
+  // Read junction boxes
+  if (!read_boxes("day8_input.txt"))
+    return 1;
+
+  result_printf(&results, "Read %d junction boxes\n", num_boxes);
+
+  // Index the boxes so only nearby pairs need to be looked at
+  KdTree tree;
+  if (!kd_build(&tree, &boxes)) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
+
+    return 1;
+  }
+
+  // Find the closest pairs, already sorted by distance
+  PairList list = {NULL, 0, 0};
+  int ok = closest_pairs(&tree, NUM_CONNECTIONS, &list);
+
+  kd_free(&tree);
+
+  if (!ok) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
+
+    return 1;
+  }
+
+  result_printf(&results, "Calculated %zu candidate pairs\n", list.count);
+
+  // Init Union-Find
+  UnionFind circuits;
+  if (!uf_init(&circuits, num_boxes)) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
+
+    return 1;
+  }
+
+  // Connect the 1000 closest pairs, or all of them if there are fewer
+  size_t num_connections =
+      list.count < NUM_CONNECTIONS ? list.count : NUM_CONNECTIONS;
+
+  for (size_t i = 0; i < num_connections; i++)
+    uf_union(&circuits, list.items[i].box1, list.items[i].box2);
+
+  free(list.items);
+
+  // Find the 3 largest circuits
+  int largest[3] = {0, 0, 0};
+  uf_top_sizes(&circuits, 3, largest);
+
+  uf_free(&circuits);
+
+  result_printf(&results, "Three largest circuits: %d, %d, %d\n", largest[0],
+                largest[1], largest[2]);
+  result_printf(&results, "Product: %lld\n",
+                (long long)largest[0] * largest[1] * largest[2]);
+
+  if (!input_cache_hit(&input)) {
+    free(boxes.x);
+    free(boxes.y);
+    free(boxes.z);
+  }
+
+  input_cache_close(&input);
+
+  result_cache_finish(&results);
+
+  return 0;
+}
+
+// Read all junction boxes into the growable coordinate arrays
+int read_boxes(const char *filename) {
+  if (!input_cache_open(&input, filename, DAY8_INPUT_KIND, 0)) {
+    printf("Error opening file\n");
+
+    return 0;
+  }
+
+  // Use the cached coordinates in place
+  if (input_cache_hit(&input)) {
+    size_t x_size, y_size, z_size;
+
+    boxes.x = (int *)input_cache_section(&input, 0, &x_size);
+    boxes.y = (int *)input_cache_section(&input, 1, &y_size);
+    boxes.z = (int *)input_cache_section(&input, 2, &z_size);
+
+    if (boxes.x && boxes.y && boxes.z && x_size == y_size &&
+        y_size == z_size) {
+      num_boxes = boxes.count = (int)(x_size / sizeof(int));
+
+      return boxes_fit();
+    }
+
+    boxes.x = boxes.y = boxes.z = NULL;
+    input_cache_reject(&input);
+  }
+
   // Open the input file for reading
-  FILE *fp = fopen("day8_input.txt", "r");
+  FILE *fp = input_cache_fopen(&input);
   if (fp == NULL) {
     printf("Error opening file\n");
 
-    return 1;
+    return 0;
   }
 
-  // Read junction boxes
-  while (fscanf(fp, "%d,%d,%d", &boxes[num_boxes].x, &boxes[num_boxes].y,
-                &boxes[num_boxes].z) == 3) {
+  int capacity = 0;
+  int x, y, z;
+
+  while (fscanf(fp, "%d,%d,%d", &x, &y, &z) == 3) {
+    if (num_boxes == capacity) {
+      capacity = capacity ? capacity * 2 : 1024;
+      int *grown_x = realloc(boxes.x, capacity * sizeof(int));
+      if (grown_x)
+        boxes.x = grown_x;
+      int *grown_y = realloc(boxes.y, capacity * sizeof(int));
+      if (grown_y)
+        boxes.y = grown_y;
+      int *grown_z = realloc(boxes.z, capacity * sizeof(int));
+      if (grown_z)
+        boxes.z = grown_z;
+
+      if (!grown_x || !grown_y || !grown_z) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        fclose(fp);
+
+        return 0;
+      }
+    }
+
+    boxes.x[num_boxes] = x;
+    boxes.y[num_boxes] = y;
+    boxes.z[num_boxes] = z;
     num_boxes++;
   }
 
+  boxes.count = num_boxes;
+
   fclose(fp);
 
-  printf("Read %d junction boxes\n", num_boxes);
+  const void *sections[] = {boxes.x, boxes.y, boxes.z};
+  size_t size = num_boxes * sizeof(int);
+  size_t sizes[] = {size, size, size};
 
-  // Calculate all pairwise distances between junction boxes
-  int num_pairs = 0;
+  input_cache_store(&input, 3, sections, sizes);
 
-  for (int i = 0; i < num_boxes; i++) {
-    for (int j = i + 1; j < num_boxes; j++) {
-      pairs[num_pairs].box1 = i;
-      pairs[num_pairs].box2 = j;
-      pairs[num_pairs].distance = calc_distance(&boxes[i], &boxes[j]);
+  return boxes_fit();
+}
 
-      num_pairs++;
-    }
-  }
+// Check that every squared distance fits its 64-bit key, and pick the
+// distance kernel while there is still only one thread
+int boxes_fit(void) {
+  if (boxes_prepare(&boxes))
+    return 1;
 
-  printf("Calculated %d pairs\n", num_pairs);
+  fprintf(stderr, "Error: Junction boxes span more than 2^31 on some axis\n");
 
-  // Sort pairs by distance
-  qsort(pairs, num_pairs, sizeof(Pair), compare_pairs);
+  return 0;
+}
 
-  // Init Union-Find
-  init_union_find(num_boxes);
+// Order on the sort key (dist2, box1, box2)
+static inline int pair_less(const Pair *a, const Pair *b) {
+  if (a->dist2 != b->dist2)
+    return a->dist2 < b->dist2;
+  if (a->box1 != b->box1)
+    return a->box1 < b->box1;
 
-  // Connect the 1000 closest pairs
-  for (int i = 0; i < 1000; i++)
-    union_sets(pairs[i].box1, pairs[i].box2);
+  return a->box2 < b->box2;
+}
 
-  // Count circuit sizes
-  int circuit_size[MAX_BOXES] = {0};
-  for (int i = 0; i < num_boxes; i++) {
-    int root = find(i);
+// Restore the max-heap below slot i
+static void pair_sift_down(Pair *heap, size_t count, size_t i) {
+  for (;;) {
+    size_t largest = i, left = 2 * i + 1, right = left + 1;
+
+    if (left < count && pair_less(&heap[largest], &heap[left]))
+      largest = left;
+    if (right < count && pair_less(&heap[largest], &heap[right]))
+      largest = right;
+    if (largest == i)
+      return;
+
+    Pair tmp = heap[i];
+    heap[i] = heap[largest];
+    heap[largest] = tmp;
+    i = largest;
+  }
+}
 
-    circuit_size[root]++;
+// Collect a candidate pair into the worker's list, growing it as needed
+// Stops the search once the workers together hold more than their cap.
+// A worker keeping only the smallest pairs swaps out its largest instead.
+static int collect_pair(int a, int b, uint64_t dist2, void *ctx) {
+  CollectWorker *worker = ctx;
+  PairList *list = &worker->list;
+  Pair pair = {dist2, (uint32_t)a, (uint32_t)b};
+
+  if (worker->keep && list->count == worker->keep) {
+    if (pair_less(&pair, &list->items[0])) {
+      list->items[0] = pair;
+      pair_sift_down(list->items, list->count, 0);
+    }
+
+    return 0;
   }
 
-  // Find the 3 largest circuits
-  int largest[3] = {0, 0, 0};
+  if (atomic_fetch_add(worker->total, 1) >= worker->cap) {
+    worker->overflow = 1;
+
+    return 1;
+  }
+
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+    Pair *grown = realloc(list->items, capacity * sizeof(Pair));
 
-  for (int i = 0; i < num_boxes; i++) {
-    if (circuit_size[i] > largest[0]) {
-      largest[2] = largest[1];
-      largest[1] = largest[0];
-      largest[0] = circuit_size[i];
-    } else if (circuit_size[i] > largest[1]) {
-      largest[2] = largest[1];
-      largest[1] = circuit_size[i];
-    } else if (circuit_size[i] > largest[2]) {
-      largest[2] = circuit_size[i];
+    if (!grown) {
+      worker->failed = 1;
+
+      return 1;
     }
+    list->items = grown;
+    list->capacity = capacity;
   }
 
-  printf("Three largest circuits: %d, %d, %d\n", largest[0], largest[1],
-         largest[2]);
-  printf("Product: %d\n", largest[0] * largest[1] * largest[2]);
+  // Sift the new pair up the heap
+  size_t i = list->count++;
+
+  while (worker->keep && i > 0 && pair_less(&list->items[(i - 1) / 2], &pair)) {
+    list->items[i] = list->items[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+
+  list->items[i] = pair;
 
   return 0;
 }
 
-// Union-Finding functions
-void init_union_find(int n) {
-  for (int i = 0; i < n; i++) {
-    parent[i] = i;
-    rank_arr[i] = 0;
+// Claim blocks of tree positions until they run out or the cap is hit
+static void collect_task(void *ctx, int index) {
+  CollectWorker *worker = (CollectWorker *)ctx + index;
+  const KdTree *tree = worker->tree;
+  int n = tree->boxes->count;
+  int *stack = malloc(tree->num_nodes * sizeof(int));
+
+  if (!stack) {
+    worker->failed = 1;
+
+    return;
   }
-}
 
-int find(int x) {
-  if (parent[x] != x)
-    parent[x] = find(parent[x]); // Path compression
+  for (;;) {
+    int begin = atomic_fetch_add(worker->next_block, 1) * QUERY_BLOCK;
+
+    if (begin >= n || atomic_load(worker->total) >= worker->cap)
+      break;
 
-  return parent[x];
+    int end = begin + QUERY_BLOCK < n ? begin + QUERY_BLOCK : n;
+
+    if (!kd_pairs_within(tree, worker->max_dist2, begin, end, collect_pair,
+                         worker, stack))
+      break;
+  }
+
+  free(stack);
 }
 
-void union_sets(int x, int y) {
-  int root_x = find(x);
-  int root_y = find(y);
+// Find the k closest pairs of boxes, sorted by distance
+// Searches a radius sized for about k pairs and widens or narrows it until
+// it holds at least k pairs without flooding memory. When ties leave no
+// radius in between, the workers keep only the k smallest pairs they find.
+// The list may hold more than k pairs, or fewer if there are fewer boxes.
+// Returns 0 on allocation failure
+int closest_pairs(const KdTree *tree, size_t k, PairList *list) {
+  size_t total_pairs = (size_t)num_boxes * (num_boxes - 1) / 2;
 
-  if (root_x == root_y)
-    return;
+  if (total_pairs < k)
+    k = total_pairs;
+
+  list->count = 0;
+
+  if (k == 0)
+    return 1;
+
+  // Expect k pairs within r when boxes are spread evenly over the bounding
+  // volume: (n^2 / 2) * (4/3 pi r^3) / volume = k
+  const KdNode *root = &tree->nodes[0];
+  double volume = 1.0;
+
+  for (int d = 0; d < 3; d++)
+    volume *= (double)root->hi[d] - root->lo[d] + 1;
+
+  double r = cbrt(3.0 * k * volume /
+                  (2.0 * 3.14159265358979 * (double)num_boxes * num_boxes));
+  uint64_t r2 = r * r < (double)KD_MAX_DIST2 ? (uint64_t)(r * r) + 1
+                                             : KD_MAX_DIST2;
+
+  // Radii known to hold too few / too many pairs, hi UINT64_MAX until found
+  uint64_t lo = 0, hi = UINT64_MAX;
+  int kept = 0; // The list only holds the smallest pairs within the radius
+
+  // Enough room for a generous estimate without going quadratic
+  size_t cap = k < 1000000 ? 16 * k + num_boxes : k + num_boxes;
+
+  int threads = pool_num_workers();
+  CollectWorker *workers = calloc(threads, sizeof(CollectWorker));
+  if (!workers)
+    return 0;
+
+  for (;;) {
+    // Once the bounds meet there is no smaller radius left to try, so every
+    // pair within it is looked at but only the k smallest are kept
+    int uncapped = hi != UINT64_MAX && hi - lo <= 1;
+    if (uncapped)
+      r2 = hi;
+
+    atomic_int next_block = 0;
+    atomic_size_t total = 0;
+
+    for (int t = 0; t < threads; t++) {
+      workers[t].tree = tree;
+      workers[t].max_dist2 = r2;
+      workers[t].list.count = 0;
+      workers[t].next_block = &next_block;
+      workers[t].total = &total;
+      workers[t].cap = uncapped ? SIZE_MAX : cap;
+      workers[t].keep = uncapped ? k : 0;
+      workers[t].overflow = 0;
+      workers[t].failed = 0;
+    }
 
-  // Union by rank
-  if (rank_arr[root_x] < rank_arr[root_y]) {
-    parent[root_x] = root_y;
-  } else if (rank_arr[root_x] > rank_arr[root_y]) {
-    parent[root_y] = root_x;
-  } else {
-    parent[root_y] = root_x;
+    pool_run(threads, collect_task, workers);
 
-    rank_arr[root_x]++;
+    size_t found = 0;
+    int finished = 1, failed = 0;
+
+    for (int t = 0; t < threads; t++) {
+      found += workers[t].list.count;
+      finished &= !workers[t].overflow;
+      failed |= workers[t].failed;
+    }
+
+    if (failed)
+      break;
+
+    if (found < k) {
+      // Too few: widen the search
+      lo = r2;
+      if (hi != UINT64_MAX)
+        r2 = lo + (hi - lo) / 2;
+      else
+        r2 = r2 < KD_MAX_DIST2 / 4 ? r2 * 4 : KD_MAX_DIST2;
+    } else if (!finished) {
+      // Too many: narrow the search
+      hi = r2;
+      r2 = lo + (hi - lo) / 2;
+    } else {
+      // Gather every worker's pairs into one list
+      kept = uncapped;
+      list->items = malloc((found > 0 ? found : 1) * sizeof(Pair));
+      list->capacity = found;
+
+      for (int t = 0; t < threads && list->items; t++) {
+        memcpy(list->items + list->count, workers[t].list.items,
+               workers[t].list.count * sizeof(Pair));
+        list->count += workers[t].list.count;
+      }
+
+      break;
+    }
   }
+
+  for (int t = 0; t < threads; t++)
+    free(workers[t].list.items);
+  free(workers);
+
+  // Sort pairs by distance
+  if (!list->items || !radix_sort_pairs(list->items, list->count))
+    return 0;
+
+  // Each worker kept its own k smallest: the k smallest of all lead the list
+  if (kept && list->count > k)
+    list->count = k;
+
+  return 1;
+}
+
+// Digit d of the sort key (dist2, box1, box2), least significant first
+static inline unsigned pair_digit(const Pair *p, int digit) {
+  if (digit < RADIX_INDEX_DIGITS)
+    return (p->box2 >> (digit * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+
+  digit -= RADIX_INDEX_DIGITS;
+  if (digit < RADIX_INDEX_DIGITS)
+    return (p->box1 >> (digit * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+
+  digit -= RADIX_INDEX_DIGITS;
+
+  return (p->dist2 >> (digit * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+}
+
+static void radix_count(void *ctx, int index) {
+  RadixSlice *slice = (RadixSlice *)ctx + index;
+
+  memset(slice->hist, 0, sizeof(slice->hist));
+
+  for (size_t i = slice->begin; i < slice->end; i++)
+    slice->hist[pair_digit(&slice->src[i], slice->digit)]++;
 }
 
-// Calc Euclidean distance
-double calc_distance(Box *a, Box *b) {
-  long long dx = (long long)a->x - b->x;
-  long long dy = (long long)a->y - b->y;
-  long long dz = (long long)a->z - b->z;
+static void radix_scatter(void *ctx, int index) {
+  RadixSlice *slice = (RadixSlice *)ctx + index;
 
-  return sqrt(dx * dx + dy * dy + dz * dz);
+  for (size_t i = slice->begin; i < slice->end; i++)
+    slice->dst[slice->hist[pair_digit(&slice->src[i], slice->digit)]++] =
+        slice->src[i];
 }
 
-// Comparison function for sorting pairs
-int compare_pairs(const void *a, const void *b) {
-  Pair *p1 = (Pair *)a;
-  Pair *p2 = (Pair *)b;
-  if (p1->distance < p2->distance)
-    return -1;
-  if (p1->distance > p2->distance)
+// Stable LSD radix sort on (dist2, box1, box2)
+// The whole key takes part, so equal distances always come out the same way.
+// Passes where every pair shares the digit are skipped, which drops most of
+// the high index and distance bytes.
+// Returns 0 on allocation failure
+int radix_sort_pairs(Pair *pairs, size_t count) {
+  if (count < 2)
     return 1;
 
-  return 0;
+  Pair *tmp = malloc(count * sizeof(Pair));
+  if (!tmp)
+    return 0;
+
+  size_t max_slices = count / RADIX_MIN_PER_THREAD;
+  int num_slices = pool_num_workers();
+
+  if ((size_t)num_slices > max_slices)
+    num_slices = max_slices > 0 ? (int)max_slices : 1;
+
+  RadixSlice *slices = malloc(num_slices * sizeof(RadixSlice));
+  if (!slices) {
+    free(tmp);
+
+    return 0;
+  }
+
+  Pair *src = pairs, *dst = tmp;
+
+  for (int digit = 0; digit < RADIX_DIGITS; digit++) {
+    for (int t = 0; t < num_slices; t++) {
+      slices[t].src = src;
+      slices[t].dst = dst;
+      slices[t].begin = count * t / num_slices;
+      slices[t].end = count * (t + 1) / num_slices;
+      slices[t].digit = digit;
+    }
+
+    pool_run(num_slices, radix_count, slices);
+
+    // Turn counts into offsets: bucket by bucket, slice by slice
+    size_t offset = 0;
+    int trivial = 0;
+
+    for (int b = 0; b < RADIX_BUCKETS && !trivial; b++) {
+      size_t bucket_start = offset;
+
+      for (int t = 0; t < num_slices; t++) {
+        size_t n = slices[t].hist[b];
+
+        slices[t].hist[b] = offset;
+        offset += n;
+      }
+
+      trivial = (offset - bucket_start == count);
+    }
+
+    if (trivial)
+      continue;
+
+    pool_run(num_slices, radix_scatter, slices);
+
+    Pair *swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != pairs)
+    memcpy(pairs, src, count * sizeof(Pair));
+
+  free(slices);
+  free(tmp);
+
+  return 1;
 }
@@ -0,0 +1,440 @@
+/*
+ * Routine: Advent of Code--Day 8: Playground (k-d tree)
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * Spatial index over the junction boxes so close pairs can be found without
+ * looking at all n^2 of them.
+ */
+
+#ifndef DAY8_KDTREE_H
+#define DAY8_KDTREE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KD_HAVE_AVX2 1
+#endif
+
+#define KD_LEAF_SIZE 16
+#define KD_MAX_SPAN (1LL << 31)   // Widest axis with exact 64-bit distances
+#define KD_MAX_DIST2 (3ULL << 62) // Squared distance across that span
+
+// Junction box coordinates, one array per axis
+typedef struct {
+  int *x, *y, *z;
+  int count;
+  int avx2; // Distances go through the AVX2 kernel, see boxes_prepare()
+} Boxes;
+
+// A node covers tree positions [start..end) inside its bounding box
+typedef struct {
+  int lo[3], hi[3];
+  int start, end;
+  int left, right; // -1 for leaves
+} KdNode;
+
+// Boxes are copied into tree order so every node's boxes are contiguous
+typedef struct {
+  const Boxes *boxes;
+  int *order;     // Box index at each tree position
+  int *x, *y, *z; // Coordinates in tree order
+  KdNode *nodes;
+  int num_nodes;
+} KdTree;
+
+// Called for every pair found, return non-zero to stop the search
+typedef int (*KdPairFn)(int a, int b, uint64_t dist2, void *ctx);
+
+// Check that no axis spans more than KD_MAX_SPAN, and pick the distance
+// kernel this CPU supports
+// Each squared difference is then at most 2^62, so a squared distance, the
+// sum of three, always fits in 64 unsigned bits. Call it before any thread
+// computes distances. Returns 0 if the boxes are too far apart.
+static inline int boxes_prepare(Boxes *boxes) {
+  const int *axes[3] = {boxes->x, boxes->y, boxes->z};
+  long long span = 0;
+
+  for (int d = 0; d < 3 && boxes->count > 0; d++) {
+    int lo = axes[d][0], hi = axes[d][0];
+
+    for (int i = 1; i < boxes->count; i++) {
+      if (axes[d][i] < lo)
+        lo = axes[d][i];
+      if (axes[d][i] > hi)
+        hi = axes[d][i];
+    }
+
+    if ((long long)hi - lo > span)
+      span = (long long)hi - lo;
+  }
+
+  boxes->avx2 = 0;
+#ifdef KD_HAVE_AVX2
+  boxes->avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+  return span <= KD_MAX_SPAN;
+}
+
+static inline uint64_t box_dist2(const Boxes *boxes, int a, int b) {
+  long long dx = (long long)boxes->x[a] - boxes->x[b];
+  long long dy = (long long)boxes->y[a] - boxes->y[b];
+  long long dz = (long long)boxes->z[a] - boxes->z[b];
+
+  return (uint64_t)(dx * dx) + (uint64_t)(dy * dy) + (uint64_t)(dz * dz);
+}
+
+// Squared distances from (qx, qy, qz) to count points, written to out
+static inline void kd_dist2_block_scalar(int qx, int qy, int qz, const int *xs,
+                                         const int *ys, const int *zs,
+                                         int count, uint64_t *out) {
+  for (int i = 0; i < count; i++) {
+    long long dx = (long long)xs[i] - qx;
+    long long dy = (long long)ys[i] - qy;
+    long long dz = (long long)zs[i] - qz;
+
+    out[i] = (uint64_t)(dx * dx) + (uint64_t)(dy * dy) + (uint64_t)(dz * dz);
+  }
+}
+
+#ifdef KD_HAVE_AVX2
+// Four 64-bit squared distances per multiply
+// The multiply squares the low 32 bits of each difference as signed, which is
+// exact for differences within +-2^31 (-2^31 squares the same as 2^31).
+// boxes_prepare() already rejects any axis spanning more than that.
+__attribute__((target("avx2"))) static inline void
+kd_dist2_block_avx2(int qx, int qy, int qz, const int *xs, const int *ys,
+                    const int *zs, int count, uint64_t *out) {
+  const __m256i vx = _mm256_set1_epi64x(qx);
+  const __m256i vy = _mm256_set1_epi64x(qy);
+  const __m256i vz = _mm256_set1_epi64x(qz);
+  int i = 0;
+
+  for (; i + 4 <= count; i += 4) {
+    __m256i dx = _mm256_sub_epi64(
+        _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(xs + i))), vx);
+    __m256i dy = _mm256_sub_epi64(
+        _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(ys + i))), vy);
+    __m256i dz = _mm256_sub_epi64(
+        _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(zs + i))), vz);
+
+    __m256i d2 = _mm256_add_epi64(
+        _mm256_add_epi64(_mm256_mul_epi32(dx, dx), _mm256_mul_epi32(dy, dy)),
+        _mm256_mul_epi32(dz, dz));
+
+    _mm256_storeu_si256((__m256i *)(out + i), d2);
+  }
+
+  kd_dist2_block_scalar(qx, qy, qz, xs + i, ys + i, zs + i, count - i,
+                        out + i);
+}
+#endif
+
+// Squared distances with the kernel boxes_prepare() picked for boxes
+static inline void kd_dist2_block(const Boxes *boxes, int qx, int qy, int qz,
+                                  const int *xs, const int *ys, const int *zs,
+                                  int count, uint64_t *out) {
+#ifdef KD_HAVE_AVX2
+  if (boxes->avx2) {
+    kd_dist2_block_avx2(qx, qy, qz, xs, ys, zs, count, out);
+
+    return;
+  }
+#endif
+  kd_dist2_block_scalar(qx, qy, qz, xs, ys, zs, count, out);
+}
+
+static inline int kd_coord(const KdTree *tree, int pos, int dim) {
+  return dim == 0 ? tree->x[pos] : (dim == 1 ? tree->y[pos] : tree->z[pos]);
+}
+
+static inline void kd_swap(KdTree *tree, int i, int j) {
+  int tmp;
+
+  tmp = tree->order[i], tree->order[i] = tree->order[j], tree->order[j] = tmp;
+  tmp = tree->x[i], tree->x[i] = tree->x[j], tree->x[j] = tmp;
+  tmp = tree->y[i], tree->y[i] = tree->y[j], tree->y[j] = tmp;
+  tmp = tree->z[i], tree->z[i] = tree->z[j], tree->z[j] = tmp;
+}
+
+// Partially sort positions [start..end) so nth holds the median on dim
+static inline void kd_select(KdTree *tree, int start, int end, int nth,
+                             int dim) {
+  while (end - start > 1) {
+    int pivot = kd_coord(tree, start + (end - start) / 2, dim);
+    int i = start, j = end - 1;
+
+    while (i <= j) {
+      while (kd_coord(tree, i, dim) < pivot)
+        i++;
+      while (kd_coord(tree, j, dim) > pivot)
+        j--;
+
+      if (i <= j) {
+        kd_swap(tree, i, j);
+
+        i++;
+        j--;
+      }
+    }
+
+    if (nth <= j)
+      end = j + 1;
+    else if (nth >= i)
+      start = i;
+    else
+      return;
+  }
+}
+
+static inline int kd_build_node(KdTree *tree, int start, int end) {
+  int id = tree->num_nodes++;
+  KdNode *node = &tree->nodes[id];
+
+  node->start = start;
+  node->end = end;
+  node->left = node->right = -1;
+
+  for (int d = 0; d < 3; d++) {
+    node->lo[d] = kd_coord(tree, start, d);
+    node->hi[d] = node->lo[d];
+  }
+
+  for (int i = start + 1; i < end; i++) {
+    for (int d = 0; d < 3; d++) {
+      int c = kd_coord(tree, i, d);
+
+      if (c < node->lo[d])
+        node->lo[d] = c;
+      if (c > node->hi[d])
+        node->hi[d] = c;
+    }
+  }
+
+  if (end - start <= KD_LEAF_SIZE)
+    return id;
+
+  // Split at the median of the widest dimension
+  int dim = 0;
+  for (int d = 1; d < 3; d++) {
+    if ((long long)node->hi[d] - node->lo[d] >
+        (long long)node->hi[dim] - node->lo[dim])
+      dim = d;
+  }
+
+  int mid = start + (end - start) / 2;
+  kd_select(tree, start, end, mid, dim);
+
+  // Children may move the node array, so don't hold on to node
+  int left = kd_build_node(tree, start, mid);
+  int right = kd_build_node(tree, mid, end);
+
+  tree->nodes[id].left = left;
+  tree->nodes[id].right = right;
+
+  return id;
+}
+
+static inline void kd_free(KdTree *tree) {
+  free(tree->order);
+  free(tree->x);
+  free(tree->y);
+  free(tree->z);
+  free(tree->nodes);
+}
+
+// Build a tree over all boxes, return 0 on allocation failure
+static inline int kd_build(KdTree *tree, const Boxes *boxes) {
+  int n = boxes->count;
+  size_t size = (n > 0 ? n : 1) * sizeof(int);
+
+  // Leaves hold at least KD_LEAF_SIZE / 2 boxes, which bounds the node count
+  int max_nodes = 2 * (n / (KD_LEAF_SIZE / 2) + 1);
+
+  tree->boxes = boxes;
+  tree->num_nodes = 0;
+  tree->order = malloc(size);
+  tree->x = malloc(size);
+  tree->y = malloc(size);
+  tree->z = malloc(size);
+  tree->nodes = malloc(max_nodes * sizeof(KdNode));
+
+  if (!tree->order || !tree->x || !tree->y || !tree->z || !tree->nodes) {
+    kd_free(tree);
+
+    return 0;
+  }
+
+  for (int i = 0; i < n; i++) {
+    tree->order[i] = i;
+    tree->x[i] = boxes->x[i];
+    tree->y[i] = boxes->y[i];
+    tree->z[i] = boxes->z[i];
+  }
+
+  if (n > 0)
+    kd_build_node(tree, 0, n);
+
+  return 1;
+}
+
+// Squared distance from a point to the nearest point of a node's bounding box
+static inline uint64_t kd_node_dist2(const KdNode *node, const int *q) {
+  uint64_t total = 0;
+
+  for (int d = 0; d < 3; d++) {
+    long long diff = 0;
+
+    if (q[d] < node->lo[d])
+      diff = (long long)node->lo[d] - q[d];
+    else if (q[d] > node->hi[d])
+      diff = (long long)q[d] - node->hi[d];
+
+    total += (uint64_t)(diff * diff);
+  }
+
+  return total;
+}
+
+// Report every pair (a, b) with a < b no further apart than sqrt(max_dist2),
+// for the boxes a at tree positions [begin..end)
+// Consecutive tree positions are close in space, so blocks of positions
+// revisit the same leaves while they are still in cache. stack needs room for
+// num_nodes entries. Returns 0 if the callback stopped the search early.
+static inline int kd_pairs_within(const KdTree *tree, uint64_t max_dist2,
+                                  int begin, int end, KdPairFn fn, void *ctx,
+                                  int *stack) {
+  uint64_t dist2[KD_LEAF_SIZE];
+
+  if (tree->num_nodes == 0)
+    return 1;
+
+  for (int pos = begin; pos < end; pos++) {
+    int a = tree->order[pos];
+    int q[3] = {tree->x[pos], tree->y[pos], tree->z[pos]};
+    int top = 0;
+
+    stack[top++] = 0;
+
+    while (top > 0) {
+      const KdNode *node = &tree->nodes[stack[--top]];
+
+      if (kd_node_dist2(node, q) > max_dist2)
+        continue;
+
+      if (node->left != -1) {
+        stack[top++] = node->left;
+        stack[top++] = node->right;
+
+        continue;
+      }
+
+      int count = node->end - node->start;
+
+      kd_dist2_block(tree->boxes, q[0], q[1], q[2], tree->x + node->start,
+                     tree->y + node->start, tree->z + node->start, count,
+                     dist2);
+
+      for (int i = 0; i < count; i++) {
+        int b = tree->order[node->start + i];
+
+        // Each pair is reported once, from its lower index
+        if (dist2[i] <= max_dist2 && b > a && fn(a, b, dist2[i], ctx))
+          return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+// Label each node with the label its boxes share, or -1 if they differ
+// Children always come after their parent in the node array
+static inline void kd_label_nodes(const KdTree *tree, const int *labels,
+                                  int *node_labels) {
+  for (int id = tree->num_nodes - 1; id >= 0; id--) {
+    const KdNode *node = &tree->nodes[id];
+
+    if (node->left != -1) {
+      int left = node_labels[node->left];
+
+      node_labels[id] = (left == node_labels[node->right]) ? left : -1;
+
+      continue;
+    }
+
+    int label = labels[tree->order[node->start]];
+
+    for (int i = node->start + 1; i < node->end && label != -1; i++) {
+      if (labels[tree->order[i]] != label)
+        label = -1;
+    }
+
+    node_labels[id] = label;
+  }
+}
+
+// Find the nearest box to box a carrying a different label
+// Only boxes beating (*best_dist2, *best_box) count, ties going to the lower
+// index. Both are updated in place, stack needs room for num_nodes entries.
+static inline void kd_nearest_other(const KdTree *tree,
+                                    const int *node_labels, const int *labels,
+                                    int a, uint64_t *best_dist2, int *best_box,
+                                    int *stack) {
+  const Boxes *boxes = tree->boxes;
+  int q[3] = {boxes->x[a], boxes->y[a], boxes->z[a]};
+  uint64_t dist2[KD_LEAF_SIZE];
+  int label = labels[a];
+  int top = 0;
+
+  stack[top++] = 0;
+
+  while (top > 0) {
+    int id = stack[--top];
+    const KdNode *node = &tree->nodes[id];
+
+    if (node_labels[id] == label || kd_node_dist2(node, q) > *best_dist2)
+      continue;
+
+    if (node->left != -1) {
+      // Visit the nearer child first so the bound tightens sooner
+      int near = node->left, far = node->right;
+
+      if (kd_node_dist2(&tree->nodes[far], q) <
+          kd_node_dist2(&tree->nodes[near], q)) {
+        near = node->right;
+        far = node->left;
+      }
+
+      stack[top++] = far;
+      stack[top++] = near;
+
+      continue;
+    }
+
+    int count = node->end - node->start;
+
+    kd_dist2_block(boxes, q[0], q[1], q[2], tree->x + node->start,
+                   tree->y + node->start, tree->z + node->start, count, dist2);
+
+    for (int i = 0; i < count; i++) {
+      int b = tree->order[node->start + i];
+
+      if (labels[b] == label)
+        continue;
+
+      if (dist2[i] < *best_dist2 ||
+          (dist2[i] == *best_dist2 && b < *best_box)) {
+        *best_dist2 = dist2[i];
+        *best_box = b;
+      }
+    }
+  }
+}
+
+#endif
@@ -6,178 +6,385 @@
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <limits.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_BOXES 1000
-#define MAX_PAIRS 500000
+#include "day8_kdtree.h"
+#include "input_cache.h"
+#include "result_cache.h"
+#include "union_find.h"
 
-// Create a structure for the junction boxes
-typedef struct {
-  int x, y, z;
-} Box;
+// Up to this many boxes the O(n^2) dense Prim is cheapest
+#define PRIM_MAX_BOXES 20000
+#define DAY8_INPUT_KIND INPUT_CACHE_KIND(8, 1)
+#define DAY8_RESULT_VERSION 1
 
-// Create a structure for connected pairs of junction boxes
+// Create a structure for a connection between two junction boxes
+// Edges order by distance, then by box indices, so ties always break the same
+// way and the spanning tree is unique
 typedef struct {
-  int box1, box2;
-  double distance;
-} Pair;
+  int box1, box2; // box1 < box2
+  uint64_t dist2;
+} Edge;
 
 // Declare initial data
-Box boxes[MAX_BOXES];
-Pair pairs[MAX_PAIRS];
-int parent[MAX_BOXES];
-int rank_arr[MAX_BOXES];
+Boxes boxes = {NULL, NULL, NULL, 0, 0};
 int num_boxes = 0;
+InputCache input; // Holds the coordinates when they come from its cache file
 
 // Prototypes
-void init_union_find(int n);
-int find(int x);
-int union_sets(int x, int y);
-int count_circuits();
-double calc_distance(Box *a, Box *b);
-int compare_pairs(const void *a, const void *b);
+int read_boxes(const char *filename);
+int boxes_fit(void);
+Edge make_edge(int a, int b, uint64_t dist2);
+int edge_less(const Edge *a, const Edge *b);
+int last_edge_prim(Edge *last);
+int last_edge_boruvka(Edge *last);
 
 int main() {
-  // Open the input file for reading
-  FILE *fp = fopen("day8_input.txt", "r");
-  if (fp == NULL) {
-    printf("Error opening file\n");
+  ResultCache results;
+  if (result_cache_open(&results, "day8_input.txt", 8, 2, DAY8_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
+  // Read junction boxes
+  if (!read_boxes("day8_input.txt"))
+    return 1;
+
+  result_printf(&results, "Read %d junction boxes\n", num_boxes);
+
+  if (num_boxes < 2) {
+    fprintf(stderr, "Error: Need at least two junction boxes\n");
 
     return 1;
   }
 
-  // Read junction boxes
-  while (fscanf(fp, "%d,%d,%d", &boxes[num_boxes].x, &boxes[num_boxes].y,
-                &boxes[num_boxes].z) == 3) {
-    num_boxes++;
+  // The last connection Kruskal would make is the longest edge of the
+  // minimum spanning tree, so build that tree without sorting every pair
+  Edge last;
+  int ok = (num_boxes <= PRIM_MAX_BOXES) ? last_edge_prim(&last)
+                                         : last_edge_boruvka(&last);
+  if (!ok) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
+
+    return 1;
   }
 
-  fclose(fp);
+  int last_box1 = last.box1, last_box2 = last.box2;
+
+  result_printf(&results, "All boxes connected after %d connections\n",
+                num_boxes - 1);
+  result_printf(&results,
+                "Last connection: box %d (%d,%d,%d) to box %d (%d,%d,%d)\n",
+                last_box1, boxes.x[last_box1], boxes.y[last_box1],
+                boxes.z[last_box1], last_box2, boxes.x[last_box2],
+                boxes.y[last_box2], boxes.z[last_box2]);
+  result_printf(&results, "Distance: %.2f\n", sqrt((double)last.dist2));
+
+  long long result =
+      (long long)boxes.x[last_box1] * (long long)boxes.x[last_box2];
+  result_printf(&results, "Product of X coordinates: %d * %d = %lld\n",
+                boxes.x[last_box1], boxes.x[last_box2], result);
+
+  if (!input_cache_hit(&input)) {
+    free(boxes.x);
+    free(boxes.y);
+    free(boxes.z);
+  }
+
+  input_cache_close(&input);
+
+  result_cache_finish(&results);
+
+  return 0;
+}
+
+// Read all junction boxes into the growable coordinate arrays
+int read_boxes(const char *filename) {
+  if (!input_cache_open(&input, filename, DAY8_INPUT_KIND, 0)) {
+    printf("Error opening file\n");
+
+    return 0;
+  }
 
-  printf("Read %d junction boxes\n", num_boxes);
+  // Use the cached coordinates in place
+  if (input_cache_hit(&input)) {
+    size_t x_size, y_size, z_size;
 
-  // Calculate all pairwise distances between junction boxes
-  int num_pairs = 0;
+    boxes.x = (int *)input_cache_section(&input, 0, &x_size);
+    boxes.y = (int *)input_cache_section(&input, 1, &y_size);
+    boxes.z = (int *)input_cache_section(&input, 2, &z_size);
 
-  for (int i = 0; i < num_boxes; i++) {
-    for (int j = i + 1; j < num_boxes; j++) {
-      pairs[num_pairs].box1 = i;
-      pairs[num_pairs].box2 = j;
-      pairs[num_pairs].distance = calc_distance(&boxes[i], &boxes[j]);
+    if (boxes.x && boxes.y && boxes.z && x_size == y_size &&
+        y_size == z_size) {
+      num_boxes = boxes.count = (int)(x_size / sizeof(int));
 
-      num_pairs++;
+      return boxes_fit();
     }
+
+    boxes.x = boxes.y = boxes.z = NULL;
+    input_cache_reject(&input);
+  }
+
+  // Open the input file for reading
+  FILE *fp = input_cache_fopen(&input);
+  if (fp == NULL) {
+    printf("Error opening file\n");
+
+    return 0;
   }
 
-  printf("Calculated %d pairs\n", num_pairs);
-
-  // Sort pairs by distance
-  qsort(pairs, num_pairs, sizeof(Pair), compare_pairs);
-
-  // Init Union-Find
-  init_union_find(num_boxes);
-
-  // Connect pairs until all junction boxes are in one circuit
-  int last_box1 = -1, last_box2 = -1;
-  int connections = 0;
-
-  for (int i = 0; i < num_pairs; i++) {
-    // Try to union these two boxes
-    if (union_sets(pairs[i].box1, pairs[i].box2)) {
-      // A connection was made
-      last_box1 = pairs[i].box1;
-      last_box2 = pairs[i].box2;
-      connections++;
-
-      // Check if all boxes are now in one circuit
-      if (count_circuits() == 1) {
-        printf("All boxes connected after %d connections\n", connections);
-        printf("Last connection: box %d (%d,%d,%d) to box %d (%d,%d,%d)\n",
-               last_box1, boxes[last_box1].x, boxes[last_box1].y,
-               boxes[last_box1].z, last_box2, boxes[last_box2].x,
-               boxes[last_box2].y, boxes[last_box2].z);
-        printf("Distance: %.2f\n", pairs[i].distance);
-
-        long long result =
-            (long long)boxes[last_box1].x * (long long)boxes[last_box2].x;
-        printf("Product of X coordinates: %d * %d = %lld\n", boxes[last_box1].x,
-               boxes[last_box2].x, result);
-
-        break;
+  int capacity = 0;
+  int x, y, z;
+
+  while (fscanf(fp, "%d,%d,%d", &x, &y, &z) == 3) {
+    if (num_boxes == capacity) {
+      capacity = capacity ? capacity * 2 : 1024;
+      int *grown_x = realloc(boxes.x, capacity * sizeof(int));
+      if (grown_x)
+        boxes.x = grown_x;
+      int *grown_y = realloc(boxes.y, capacity * sizeof(int));
+      if (grown_y)
+        boxes.y = grown_y;
+      int *grown_z = realloc(boxes.z, capacity * sizeof(int));
+      if (grown_z)
+        boxes.z = grown_z;
+
+      if (!grown_x || !grown_y || !grown_z) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        fclose(fp);
+
+        return 0;
       }
     }
+
+    boxes.x[num_boxes] = x;
+    boxes.y[num_boxes] = y;
+    boxes.z[num_boxes] = z;
+    num_boxes++;
   }
 
+  boxes.count = num_boxes;
+
+  fclose(fp);
+
+  const void *sections[] = {boxes.x, boxes.y, boxes.z};
+  size_t size = num_boxes * sizeof(int);
+  size_t sizes[] = {size, size, size};
+
+  input_cache_store(&input, 3, sections, sizes);
+
+  return boxes_fit();
+}
+
+// Check that every squared distance fits its 64-bit key, and pick the
+// distance kernel while there is still only one thread
+int boxes_fit(void) {
+  if (boxes_prepare(&boxes))
+    return 1;
+
+  fprintf(stderr, "Error: Junction boxes span more than 2^31 on some axis\n");
+
   return 0;
 }
 
-// Union-Finding functions
-void init_union_find(int n) {
-  for (int i = 0; i < n; i++) {
-    parent[i] = i;
-    rank_arr[i] = 0;
-  }
+Edge make_edge(int a, int b, uint64_t dist2) {
+  Edge e = {a < b ? a : b, a < b ? b : a, dist2};
+
+  return e;
 }
 
-int find(int x) {
-  if (parent[x] != x)
-    parent[x] = find(parent[x]); // Path compression
+// Total order on edges: distance first, then box indices
+int edge_less(const Edge *a, const Edge *b) {
+  if (a->dist2 != b->dist2)
+    return a->dist2 < b->dist2;
+  if (a->box1 != b->box1)
+    return a->box1 < b->box1;
 
-  return parent[x];
+  return a->box2 < b->box2;
 }
 
-// Returns 1 if union was performed, 0 if they were already in same set
-int union_sets(int x, int y) {
-  int root_x = find(x);
-  int root_y = find(y);
+// Dense Prim: grow one circuit, always adding the box nearest to it
+// O(n^2) time but only O(n) memory, and no pairs are ever stored. Boxes still
+// outside the tree are kept packed at the front of their own arrays, so each
+// step runs the distance kernel over exactly the boxes left to relax.
+int last_edge_prim(Edge *last) {
+  int n = num_boxes;
+  int *out_x = malloc(n * sizeof(int));
+  int *out_y = malloc(n * sizeof(int));
+  int *out_z = malloc(n * sizeof(int));
+  int *out_box = malloc(n * sizeof(int));
+  int *from = malloc(n * sizeof(int)); // Tree end of the best edge so far
+  uint64_t *best = malloc(n * sizeof(uint64_t));
+  uint64_t *row = malloc(n * sizeof(uint64_t));
+
+  if (!out_x || !out_y || !out_z || !out_box || !from || !best || !row) {
+    free(out_x);
+    free(out_y);
+    free(out_z);
+    free(out_box);
+    free(from);
+    free(best);
+    free(row);
+
+    return 0;
+  }
+
+  // Start the tree from box 0
+  int current = 0;
+  int outside = n - 1;
+
+  for (int i = 0; i < outside; i++) {
+    out_box[i] = i + 1;
+    out_x[i] = boxes.x[i + 1];
+    out_y[i] = boxes.y[i + 1];
+    out_z[i] = boxes.z[i + 1];
+    best[i] = UINT64_MAX;
+    from[i] = -1;
+  }
+
+  // Below every real edge
+  *last = make_edge(-1, -1, 0);
+
+  while (outside > 0) {
+    // Distances from the box just added, a vector at a time
+    kd_dist2_block(&boxes, boxes.x[current], boxes.y[current],
+                   boxes.z[current], out_x, out_y, out_z, outside, row);
+
+    // Relax every box outside the tree against the box just added
+    for (int i = 0; i < outside; i++) {
+      if (row[i] < best[i]) {
+        best[i] = row[i];
+        from[i] = current;
+      } else if (row[i] == best[i]) {
+        Edge old_edge = make_edge(out_box[i], from[i], best[i]);
+        Edge new_edge = make_edge(out_box[i], current, row[i]);
+
+        if (edge_less(&new_edge, &old_edge))
+          from[i] = current;
+      }
+    }
+
+    // Pick the box with the cheapest edge into the tree
+    int next = 0;
+    Edge next_edge = make_edge(out_box[0], from[0], best[0]);
+
+    for (int i = 1; i < outside; i++) {
+      if (best[i] > next_edge.dist2)
+        continue;
+
+      Edge e = make_edge(out_box[i], from[i], best[i]);
+
+      if (edge_less(&e, &next_edge)) {
+        next = i;
+        next_edge = e;
+      }
+    }
 
-  if (root_x == root_y)
-    return 0; // Already in same circuit
+    if (edge_less(last, &next_edge))
+      *last = next_edge;
 
-  // Union by rank
-  if (rank_arr[root_x] < rank_arr[root_y]) {
-    parent[root_x] = root_y;
-  } else if (rank_arr[root_x] > rank_arr[root_y]) {
-    parent[root_y] = root_x;
-  } else {
-    parent[root_y] = root_x;
+    current = out_box[next];
 
-    rank_arr[root_x]++;
+    // Move the last outside box into the freed slot
+    outside--;
+    out_box[next] = out_box[outside];
+    out_x[next] = out_x[outside];
+    out_y[next] = out_y[outside];
+    out_z[next] = out_z[outside];
+    best[next] = best[outside];
+    from[next] = from[outside];
   }
 
-  return 1; // Union was performed
+  free(out_x);
+  free(out_y);
+  free(out_z);
+  free(out_box);
+  free(from);
+  free(best);
+  free(row);
+
+  return 1;
 }
 
-// Count the number of distinct circuits
-int count_circuits() {
-  int circuits = 0;
-  for (int i = 0; i < num_boxes; i++) {
-    if (find(i) == i)
-      circuits++;
+// Boruvka: every circuit joins its nearest neighbouring circuit each round,
+// so at most log2(n) rounds of k-d tree nearest-neighbour searches are needed
+int last_edge_boruvka(Edge *last) {
+  KdTree tree;
+
+  if (!kd_build(&tree, &boxes))
+    return 0;
+
+  int *labels = malloc(num_boxes * sizeof(int));
+  int *node_labels = malloc(tree.num_nodes * sizeof(int));
+  int *stack = malloc(tree.num_nodes * sizeof(int));
+  Edge *best = malloc(num_boxes * sizeof(Edge)); // Per circuit root
+  UnionFind circuits = {NULL, NULL, NULL, NULL, 0, 0};
+
+  if (!labels || !node_labels || !stack || !best ||
+      !uf_init(&circuits, num_boxes)) {
+    kd_free(&tree);
+    free(labels);
+    free(node_labels);
+    free(stack);
+    free(best);
+    uf_free(&circuits);
+
+    return 0;
   }
-  return circuits;
-}
 
-// Calc Euclidean distance
-double calc_distance(Box *a, Box *b) {
-  long long dx = (long long)a->x - b->x;
-  long long dy = (long long)a->y - b->y;
-  long long dz = (long long)a->z - b->z;
+  int added = 0;
 
-  return sqrt(dx * dx + dy * dy + dz * dz);
-}
+  while (circuits.components > 1) {
+    for (int i = 0; i < num_boxes; i++) {
+      labels[i] = uf_find(&circuits, i);
+      best[i] = make_edge(i, i, UINT64_MAX);
+    }
 
-// Comparison function for sorting pairs
-int compare_pairs(const void *a, const void *b) {
-  Pair *p1 = (Pair *)a;
-  Pair *p2 = (Pair *)b;
-  if (p1->distance < p2->distance)
-    return -1;
-  if (p1->distance > p2->distance)
-    return 1;
+    kd_label_nodes(&tree, labels, node_labels);
 
-  return 0;
+    // Cheapest edge leaving each circuit
+    for (int a = 0; a < num_boxes; a++) {
+      Edge *circuit_best = &best[labels[a]];
+      uint64_t dist2 = circuit_best->dist2;
+      int other = INT_MAX;
+
+      kd_nearest_other(&tree, node_labels, labels, a, &dist2, &other, stack);
+
+      if (other == INT_MAX)
+        continue;
+
+      Edge e = make_edge(a, other, dist2);
+
+      if (edge_less(&e, circuit_best))
+        *circuit_best = e;
+    }
+
+    // Edges are totally ordered, so these never close a cycle
+    for (int i = 0; i < num_boxes && circuits.components > 1; i++) {
+      if (labels[i] != i || best[i].dist2 == UINT64_MAX)
+        continue;
+
+      if (uf_union(&circuits, best[i].box1, best[i].box2)) {
+        if (added == 0 || edge_less(last, &best[i]))
+          *last = best[i];
+
+        added++;
+      }
+    }
+  }
+
+  kd_free(&tree);
+  free(labels);
+  free(node_labels);
+  free(stack);
+  free(best);
+  uf_free(&circuits);
+
+  return 1;
 }
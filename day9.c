@@ -6,68 +6,261 @@
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_POINTS 1000
+#include "input_cache.h"
+#include "result_cache.h"
+
+#define DAY9_INPUT_KIND INPUT_CACHE_KIND(9, 1)
+#define DAY9_RESULT_VERSION 1
 
 typedef struct {
   int x;
   int y;
 } Point;
 
+// Prototypes
+int read_points(const char *filename, Point **points);
+int compare_points(const void *a, const void *b);
+long long largest_rectangle(const Point *sorted, int count, Point *lower,
+                            Point *upper);
+int lower_staircase(const Point *sorted, int count, Point *out);
+int upper_staircase(const Point *sorted, int count, Point *out);
+long long corner_area(Point a, Point b);
+long long best_across(const Point *lower, int lo, int hi, const Point *upper,
+                      int opt_lo, int opt_hi);
+
 int main(void) {
+  ResultCache results;
+  if (result_cache_open(&results, "day9_input.txt", 9, 1, DAY9_RESULT_VERSION,
+                        0, NULL))
+    return 0;
+
   // Init main variables
-  FILE *fp;
-  Point points[MAX_POINTS];
-  int count = 0;
+  Point *points = NULL;
   long long max_area = 0;
 
-  // Open puzzle input file
-  fp = fopen("day9_input.txt", "r");
-  if (fp == NULL) {
-    fprintf(stderr, "Error: Could not open day9_input.txt\n");
+  // Parse all coordinate pairs from input file
+  int count = read_points("day9_input.txt", &points);
+  if (count < 0)
+    return 1;
+
+  if (count == 0) {
+    fprintf(stderr, "Error: No points read from input file\n");
 
     return 1;
   }
 
-  // Parse all coordinate pairs from input file
-  while (count < MAX_POINTS &&
-         fscanf(fp, "%d,%d", &points[count].x, &points[count].y) == 2) {
-    count++;
+  result_printf(&results, "Tile coordinates read from input: %d\n", count);
+
+  Point *lower = malloc(count * sizeof(Point));
+  Point *upper = malloc(count * sizeof(Point));
+  if (!lower || !upper) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
+
+    return 1;
+  }
+
+  if (count > 1) {
+    // Opposite corners either run lower left to upper right...
+    qsort(points, count, sizeof(Point), compare_points);
+    max_area = largest_rectangle(points, count, lower, upper);
+
+    // ...or upper left to lower right, which is the same search with the
+    // y axis flipped
+    for (int i = 0; i < count; i++)
+      points[i].y = -points[i].y;
+
+    qsort(points, count, sizeof(Point), compare_points);
+    long long flipped = largest_rectangle(points, count, lower, upper);
+
+    if (flipped > max_area)
+      max_area = flipped;
+  }
+
+  result_printf(&results, "Largest rectangle area: %lld\n", max_area);
+
+  free(lower);
+  free(upper);
+  free(points);
+
+  result_cache_finish(&results);
+
+  return 0;
+}
+
+// Read all red tile coordinates into a growable array
+// Returns the number of points, or -1 on failure
+int read_points(const char *filename, Point **points) {
+  InputCache input;
+  if (!input_cache_open(&input, filename, DAY9_INPUT_KIND, 0)) {
+    fprintf(stderr, "Error: Could not open %s\n", filename);
+
+    return -1;
+  }
+
+  int count = 0, capacity = 0;
+
+  // Cached points are copied out, since the solver may reorder them
+  if (input_cache_hit(&input)) {
+    size_t bytes;
+    const Point *cached = input_cache_section(&input, 0, &bytes);
+
+    count = (int)(bytes / sizeof(Point));
+    *points = malloc((count ? count : 1) * sizeof(Point));
+
+    if (*points)
+      memcpy(*points, cached, count * sizeof(Point));
+    else
+      fprintf(stderr, "Error: Memory allocation failed\n");
+
+    input_cache_close(&input);
+
+    return *points ? count : -1;
+  }
+
+  FILE *fp = input_cache_fopen(&input);
+  if (fp == NULL) {
+    fprintf(stderr, "Error: Could not open %s\n", filename);
+    input_cache_close(&input);
+
+    return -1;
+  }
+
+  Point p;
+
+  while (fscanf(fp, "%d,%d", &p.x, &p.y) == 2) {
+    if (count == capacity) {
+      capacity = capacity ? capacity * 2 : 1024;
+      Point *grown = realloc(*points, capacity * sizeof(Point));
+
+      if (!grown) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        fclose(fp);
+        input_cache_close(&input);
+
+        return -1;
+      }
+      *points = grown;
+    }
+
+    points[0][count++] = p;
   }
 
   fclose(fp);
 
-  if (count == 0) {
-    fprintf(stderr, "Error: No points read from input file\n");
+  const void *sections[] = {*points};
+  size_t bytes = count * sizeof(Point);
 
-    return 1;
+  input_cache_store(&input, 1, sections, &bytes);
+  input_cache_close(&input);
+
+  return count;
+}
+
+// Sort by x, then y
+int compare_points(const void *a, const void *b) {
+  const Point *p = a, *q = b;
+
+  if (p->x != q->x)
+    return (p->x > q->x) - (p->x < q->x);
+
+  return (p->y > q->y) - (p->y < q->y);
+}
+
+// Largest rectangle with its lower left and upper right corners in the set
+// The lower left corner can always be slid to a point with nothing below and
+// left of it, and the upper right to one with nothing above and right of it,
+// without shrinking the rectangle. Those extreme points form two staircases,
+// and only pairs across them need checking.
+long long largest_rectangle(const Point *sorted, int count, Point *lower,
+                            Point *upper) {
+  int num_lower = lower_staircase(sorted, count, lower);
+  int num_upper = upper_staircase(sorted, count, upper);
+
+  return best_across(lower, 0, num_lower - 1, upper, 0, num_upper - 1);
+}
+
+// Points with nothing else below and to the left, by x ascending
+// Their y values strictly decrease along the staircase.
+int lower_staircase(const Point *sorted, int count, Point *out) {
+  int n = 0;
+
+  for (int i = 0; i < count; i++)
+    if (n == 0 || sorted[i].y < out[n - 1].y)
+      out[n++] = sorted[i];
+
+  return n;
+}
+
+// Points with nothing else above and to the right, by x ascending
+// Their y values strictly decrease along the staircase.
+int upper_staircase(const Point *sorted, int count, Point *out) {
+  int n = 0;
+
+  for (int i = count - 1; i >= 0; i--)
+    if (n == 0 || sorted[i].y > out[n - 1].y)
+      out[n++] = sorted[i];
+
+  // Collected right to left
+  for (int i = 0, j = n - 1; i < j; i++, j--) {
+    Point tmp = out[i];
+    out[i] = out[j];
+    out[j] = tmp;
   }
 
-  printf("Tile coordinates read from input: %d\n", count);
+  return n;
+}
+
+// Signed area with a as the lower left corner and b the upper right
+// +1 because coordinates represent tile positions, not boundaries. A pair
+// the wrong way round on one axis scores zero or less, which keeps the
+// best partner monotone along the staircases.
+long long corner_area(Point a, Point b) {
+  long long width = (long long)b.x - a.x + 1;
+  long long height = (long long)b.y - a.y + 1;
 
-  // Check all pairs of points to find largest rectangle
-  for (int i = 0; i < count; i++) {
-    for (int j = i + 1; j < count; j++) {
-      int dx = points[j].x - points[i].x;
-      int dy = points[j].y - points[i].y;
+  // Both the wrong way round can't happen across the two staircases, but
+  // keep it from looking like a valid rectangle all the same
+  if (width <= 0 && height <= 0)
+    return -width * height;
+
+  return width * height;
+}
 
-      // Calc area using absolute values to handle any ordering
-      // +1 because coordinates represent tile positions, not boundaries
-      long long width = (dx < 0) ? -dx : dx;
-      long long height = (dy < 0) ? -dy : dy;
-      width += 1;
-      height += 1;
-      long long area = width * height;
+// Best pair for the lower corners lo..hi, whose partners lie in opt_lo..opt_hi
+// As the lower corner moves right along its staircase its best upper corner
+// never moves left, so halving the lower range halves the partners to scan:
+// O((h + u) log h) in all for h lower and u upper corners.
+long long best_across(const Point *lower, int lo, int hi, const Point *upper,
+                      int opt_lo, int opt_hi) {
+  if (lo > hi)
+    return 0;
 
-      if (area > max_area)
-        max_area = area;
+  int mid = lo + (hi - lo) / 2;
+  int opt = opt_lo;
+  long long best = corner_area(lower[mid], upper[opt_lo]);
+
+  for (int j = opt_lo + 1; j <= opt_hi; j++) {
+    long long area = corner_area(lower[mid], upper[j]);
+
+    if (area > best) {
+      best = area;
+      opt = j;
     }
   }
 
-  printf("Largest rectangle area: %lld\n", max_area);
+  long long left = best_across(lower, lo, mid - 1, upper, opt_lo, opt);
+  long long right = best_across(lower, mid + 1, hi, upper, opt, opt_hi);
 
-  return 0;
+  if (left > best)
+    best = left;
+  if (right > best)
+    best = right;
+
+  return best;
 }
@@ -4,230 +4,774 @@
  * Author: DannyBimma
  *
  * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * To compile: gcc -std=c11 -O2 day9_part2.c -pthread -o day9_part2
+ * Pass --progress to report search progress on stderr.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_POINTS 1000
-#define MAX_COORD 200000
+#include "input_cache.h"
+#include "result_cache.h"
+#include "work_pool.h"
+
+#define DAY9_INPUT_KIND INPUT_CACHE_KIND(9, 1)
+#define DAY9_RESULT_VERSION 1
 
 typedef struct {
   int x;
   int y;
 } Point;
 
+// Polygon edges, stored with their ends in increasing order
+typedef struct {
+  int x, y1, y2;
+} VEdge;
+
+typedef struct {
+  int y, x1, x2;
+} HEdge;
+
+// Query structure over the polygon
+// Vertical edges crossing a rightward ray are found through a segment tree
+// over the y axis: each node lists, sorted by x, the edges spanning its whole
+// range. Horizontal edges are sorted so a row can find the ones lying on it.
+typedef struct {
+  VEdge *verticals;
+  HEdge *horizontals; // By (y, x1)
+  int num_verticals, num_horizontals;
+  int *ys; // Distinct vertex y values, sorted
+  int num_ys;
+  int num_cells;   // y cells: even = a vertex y, odd = the gap after it
+  int *node_start; // Segment tree node -> slice of node_xs
+  int *node_xs;
+} PolygonIndex;
+
+// The polygon rasterised on a compressed grid
+// Even cells are the distinct red tile coordinates, odd cells the runs of
+// tiles between two neighbouring ones, so every cell is wholly inside or
+// wholly outside. bad_sum is the 2D prefix sum of cells outside the polygon.
+typedef struct {
+  int *xs, *ys; // Distinct coordinates, sorted
+  int num_xs, num_ys;
+  int width, height; // Cells per row / column
+  unsigned *bad_sum; // (height + 1) x (width + 1)
+} CompressedGrid;
+
+// A red tile as a rectangle corner, with the largest area any rectangle
+// through it could reach inside the bounding box of all tiles
+typedef struct {
+  int x, y;
+  int cell_x, cell_y; // Compressed grid cell
+  int id;             // Input order, for tie-breaks
+  long long bound;
+} Corner;
+
+// State shared by the search threads
+// Corners are sorted by bound, largest first. A thread claims a corner and
+// pairs it with every later one; since no rectangle beats the bounds of its
+// corners, each thread stops as soon as the bounds fall below max_area.
+typedef struct {
+  const Corner *corners;
+  int count;
+  const CompressedGrid *grid;
+  atomic_int next_corner;
+  atomic_llong max_area; // Best area so far, read without the lock
+  pthread_mutex_t best_lock;
+  int best_a, best_b; // Corners of the best rectangle, under best_lock
+  atomic_int corners_done;
+  bool progress;
+} RectangleSearch;
+
 // Prototypes
-bool is_inside_or_on_polygon(Point *points, int count, int px, int py);
-bool check_rectangle_valid(Point *points, int count, int min_x, int max_x,
-                           int min_y, int max_y);
+bool build_polygon_index(PolygonIndex *index, Point *points, int count);
+void free_polygon_index(PolygonIndex *index);
+bool classify_row(const PolygonIndex *index, int py, const int *xs, int count,
+                  bool *inside);
+int read_points(const char *filename, Point **points);
+bool build_grid(CompressedGrid *grid, const PolygonIndex *index,
+                Point *points, int count);
+void free_grid(CompressedGrid *grid);
+int grid_index(const int *coords, int num_coords, int value);
+bool check_rectangle_valid(const CompressedGrid *grid, int cx1, int cx2,
+                           int cy1, int cy2);
+int compare_corners(const void *a, const void *b);
+void search_task(void *ctx, int index);
+
+int main(int argc, char **argv) {
+  ResultCache results;
+  if (result_cache_open(&results, "day9_input.txt", 9, 2, DAY9_RESULT_VERSION,
+                        0, NULL))
+    return 0;
 
-int main(void) {
   // Init main variables
-  FILE *fp;
-  Point points[MAX_POINTS];
-  int count = 0;
-  long long max_area = 0;
+  Point *points = NULL;
+  bool progress = argc > 1 && strcmp(argv[1], "--progress") == 0;
 
   // Open file input puzzle for reading
-  fp = fopen("day9_input.txt", "r");
-  if (fp == NULL) {
-    fprintf(stderr, "Error: Could not open day9_input.txt\n");
+  int count = read_points("day9_input.txt", &points);
+  if (count < 0)
+    return 1;
+
+  if (count == 0) {
+    fprintf(stderr, "Error: No points read from input file\n");
 
     return 1;
   }
 
-  while (count < MAX_POINTS &&
-         fscanf(fp, "%d,%d", &points[count].x, &points[count].y) == 2) {
-    count++;
-  }
+  result_printf(&results, "Tiles read: %d\n", count);
 
-  fclose(fp);
+  // Index the edges, then rasterise the polygon once so each rectangle check
+  // is O(1)
+  PolygonIndex index;
+  CompressedGrid grid;
+  if (!build_polygon_index(&index, points, count) ||
+      !build_grid(&grid, &index, points, count)) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
 
-  if (count == 0) {
-    fprintf(stderr, "Error: No points read from input file\n");
+    return 1;
+  }
+
+  // Every red tile as a corner, with its compressed cell and area bound
+  Corner *corners = malloc(count * sizeof(Corner));
+  if (!corners) {
+    fprintf(stderr, "Error: Memory allocation failed\n");
 
     return 1;
   }
 
-  printf("Tiles read: %d\n", count);
+  int min_x = points[0].x, max_x = points[0].x;
+  int min_y = points[0].y, max_y = points[0].y;
+
+  for (int i = 1; i < count; i++) {
+    min_x = points[i].x < min_x ? points[i].x : min_x;
+    max_x = points[i].x > max_x ? points[i].x : max_x;
+    min_y = points[i].y < min_y ? points[i].y : min_y;
+    max_y = points[i].y > max_y ? points[i].y : max_y;
+  }
 
-  // Check all pairs of red tiles
   for (int i = 0; i < count; i++) {
-    if (i % 50 == 0)
-      printf("Processing tiles: checking rectangles with corner: %d/%d...\n", i,
-             count);
+    Corner *c = &corners[i];
+    long long reach_x = points[i].x - min_x > max_x - points[i].x
+                            ? points[i].x - min_x
+                            : max_x - points[i].x;
+    long long reach_y = points[i].y - min_y > max_y - points[i].y
+                            ? points[i].y - min_y
+                            : max_y - points[i].y;
+
+    c->x = points[i].x;
+    c->y = points[i].y;
+    c->cell_x = grid_index(grid.xs, grid.num_xs, points[i].x);
+    c->cell_y = grid_index(grid.ys, grid.num_ys, points[i].y);
+    c->id = i;
+    c->bound = (reach_x + 1) * (reach_y + 1);
+  }
 
-    for (int j = i + 1; j < count; j++) {
-      int min_x = (points[i].x < points[j].x) ? points[i].x : points[j].x;
-      int max_x = (points[i].x > points[j].x) ? points[i].x : points[j].x;
-      int min_y = (points[i].y < points[j].y) ? points[i].y : points[j].y;
-      int max_y = (points[i].y > points[j].y) ? points[i].y : points[j].y;
+  // Most promising corners first, so a large rectangle is found early and
+  // prunes everything after it
+  qsort(corners, count, sizeof(Corner), compare_corners);
 
-      long long width = max_x - min_x + 1;
-      long long height = max_y - min_y + 1;
-      long long area = width * height;
+  // Check pairs of red tiles across all cores
+  RectangleSearch search;
+  search.corners = corners;
+  search.count = count;
+  search.grid = &grid;
+  atomic_init(&search.next_corner, 0);
+  atomic_init(&search.max_area, 0);
+  pthread_mutex_init(&search.best_lock, NULL);
+  search.best_a = search.best_b = -1;
+  atomic_init(&search.corners_done, 0);
+  search.progress = progress;
 
-      // Skip if not potentially better than current max
-      if (area <= max_area)
-        continue;
+  // One search per core, all claiming corners from the same counter
+  pool_run(pool_num_workers(), search_task, &search);
 
-      // Check if this rectangle is valid
-      if (check_rectangle_valid(points, count, min_x, max_x, min_y, max_y)) {
-        max_area = area;
-        printf("Valid rectangle found: corners at (%d,%d) and (%d,%d), area: "
-               "%lld\n",
-               points[i].x, points[i].y, points[j].x, points[j].y, area);
-      }
+  pthread_mutex_destroy(&search.best_lock);
+
+  long long max_area = atomic_load(&search.max_area);
+
+  if (progress)
+    fprintf(stderr, "\n");
+
+  if (search.best_a >= 0) {
+    const Corner *a = &corners[search.best_a], *b = &corners[search.best_b];
+
+    // Report the corners in input order
+    if (a->id > b->id) {
+      const Corner *tmp = a;
+      a = b;
+      b = tmp;
     }
+
+    result_printf(&results,
+                  "Valid rectangle found: corners at (%d,%d) and (%d,%d), "
+                  "area: %lld\n",
+                  a->x, a->y, b->x, b->y, max_area);
   }
 
-  printf("\nLargest rectangle area: (red/green only): %lld\n", max_area);
+  result_printf(&results, "\nLargest rectangle area: (red/green only): %lld\n",
+                max_area);
+
+  free(corners);
+  free_grid(&grid);
+  free_polygon_index(&index);
+  free(points);
+
+  result_cache_finish(&results);
 
   return 0;
 }
 
-// Check if point is exactly on a red tile
-bool is_red(Point *points, int count, int px, int py) {
-  for (int i = 0; i < count; i++) {
-    if (points[i].x == px && points[i].y == py)
-      return true;
+// Read all red tile coordinates into a growable array
+// Returns the number of points, or -1 on failure
+int read_points(const char *filename, Point **points) {
+  InputCache input;
+  if (!input_cache_open(&input, filename, DAY9_INPUT_KIND, 0)) {
+    fprintf(stderr, "Error: Could not open %s\n", filename);
+
+    return -1;
   }
 
-  return false;
-}
+  int count = 0, capacity = 0;
 
-// Check if point is on the edge between two consecutive red tiles
-bool is_on_edge(Point *points, int count, int px, int py) {
-  for (int i = 0; i < count; i++) {
-    int next = (i + 1) % count;
-    Point p1 = points[i];
-    Point p2 = points[next];
-
-    // Check if point is on the horizontal or vertical line segment
-    if (p1.x == p2.x && px == p1.x) {
-      // Vertical segment
-      int min_y = (p1.y < p2.y) ? p1.y : p2.y;
-      int max_y = (p1.y > p2.y) ? p1.y : p2.y;
-
-      if (py >= min_y && py <= max_y)
-        return true;
-    } else if (p1.y == p2.y && py == p1.y) {
-      // Horizontal segment
-      int min_x = (p1.x < p2.x) ? p1.x : p2.x;
-      int max_x = (p1.x > p2.x) ? p1.x : p2.x;
-
-      if (px >= min_x && px <= max_x)
-        return true;
+  // Cached points are copied out, since the solver may reorder them
+  if (input_cache_hit(&input)) {
+    size_t bytes;
+    const Point *cached = input_cache_section(&input, 0, &bytes);
+
+    count = (int)(bytes / sizeof(Point));
+    *points = malloc((count ? count : 1) * sizeof(Point));
+
+    if (*points)
+      memcpy(*points, cached, count * sizeof(Point));
+    else
+      fprintf(stderr, "Error: Memory allocation failed\n");
+
+    input_cache_close(&input);
+
+    return *points ? count : -1;
+  }
+
+  FILE *fp = input_cache_fopen(&input);
+  if (fp == NULL) {
+    fprintf(stderr, "Error: Could not open %s\n", filename);
+    input_cache_close(&input);
+
+    return -1;
+  }
+
+  Point p;
+
+  while (fscanf(fp, "%d,%d", &p.x, &p.y) == 2) {
+    if (count == capacity) {
+      capacity = capacity ? capacity * 2 : 1024;
+      Point *grown = realloc(*points, capacity * sizeof(Point));
+
+      if (!grown) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        fclose(fp);
+        input_cache_close(&input);
+
+        return -1;
+      }
+      *points = grown;
     }
+
+    points[0][count++] = p;
   }
 
-  return false;
+  fclose(fp);
+
+  const void *sections[] = {*points};
+  size_t bytes = count * sizeof(Point);
+
+  input_cache_store(&input, 1, sections, &bytes);
+  input_cache_close(&input);
+
+  return count;
+}
+
+static int compare_ints(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+
+  return (x > y) - (x < y);
 }
 
-// Check if point is inside the polygon using ray casting
-// Use ray casting algorithm - cast ray to the right
-bool is_inside_polygon(Point *points, int count, int px, int py) {
-  int crossings = 0;
+// Sort and de-duplicate values in place, return how many are left
+static int unique_sorted(int *values, int count) {
+  qsort(values, count, sizeof(int), compare_ints);
 
+  int kept = 0;
   for (int i = 0; i < count; i++) {
-    int next = (i + 1) % count;
-    Point p1 = points[i];
-    Point p2 = points[next];
-
-    // Only vertical edges can cross a horizontal ray
-    if (p1.x == p2.x) {
-      int edge_x = p1.x;
-      int min_y = (p1.y < p2.y) ? p1.y : p2.y;
-      int max_y = (p1.y > p2.y) ? p1.y : p2.y;
-
-      // Check if ray crosses this edge
-      // Edge must be to the right, and y must be in range
-      if (edge_x > px && py >= min_y && py < max_y)
-        crossings++;
-    }
+    if (kept == 0 || values[i] != values[kept - 1])
+      values[kept++] = values[i];
   }
 
-  return (crossings % 2) == 1;
+  return kept;
 }
 
-// Check if point is inside or on the polygon boundary
-bool is_inside_or_on_polygon(Point *points, int count, int px, int py) {
-  if (is_red(points, count, px, py))
-    return true;
+static int compare_hedges(const void *a, const void *b) {
+  const HEdge *e = a, *f = b;
 
-  if (is_on_edge(points, count, px, py))
-    return true;
+  if (e->y != f->y)
+    return (e->y > f->y) - (e->y < f->y);
 
-  if (is_inside_polygon(points, count, px, py))
-    return true;
+  return (e->x1 > f->x1) - (e->x1 < f->x1);
+}
+
+// Cell on the index's y axis, or -1 above / below every vertex
+static int y_cell(const PolygonIndex *index, int y) {
+  if (index->num_ys == 0 || y < index->ys[0] ||
+      y > index->ys[index->num_ys - 1])
+    return -1;
 
-  return false;
+  int lo = 0, hi = index->num_ys - 1;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+
+    if (index->ys[mid] < y)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return index->ys[lo] == y ? 2 * lo : 2 * lo - 1;
 }
 
-// Optimised check for rectangle validity
-bool check_rectangle_valid(Point *points, int count, int min_x, int max_x,
-                           int min_y, int max_y) {
-  // First, check all four corners - quick rejection test
-  if (!is_inside_or_on_polygon(points, count, min_x, min_y))
-    return false;
+// Visit the canonical segment tree nodes covering cells [lo..hi]
+// Filling: node_start holds counts on the first pass, write cursors on the
+// second
+static void tree_insert(PolygonIndex *index, int node, int node_lo,
+                        int node_hi, int lo, int hi, int x, bool fill) {
+  if (hi < node_lo || node_hi < lo)
+    return;
+
+  if (lo <= node_lo && node_hi <= hi) {
+    if (fill)
+      index->node_xs[index->node_start[node]++] = x;
+    else
+      index->node_start[node + 1]++;
+
+    return;
+  }
 
-  if (!is_inside_or_on_polygon(points, count, max_x, min_y))
-    return false;
+  int mid = node_lo + (node_hi - node_lo) / 2;
 
-  if (!is_inside_or_on_polygon(points, count, min_x, max_y))
-    return false;
+  tree_insert(index, 2 * node + 1, node_lo, mid, lo, hi, x, fill);
+  tree_insert(index, 2 * node + 2, mid + 1, node_hi, lo, hi, x, fill);
+}
+
+void free_polygon_index(PolygonIndex *index) {
+  free(index->verticals);
+  free(index->horizontals);
+  free(index->ys);
+  free(index->node_start);
+  free(index->node_xs);
+}
+
+bool build_polygon_index(PolygonIndex *index, Point *points, int count) {
+  memset(index, 0, sizeof(*index));
+
+  index->verticals = malloc(count * sizeof(VEdge));
+  index->horizontals = malloc(count * sizeof(HEdge));
+  index->ys = malloc(count * sizeof(int));
+
+  if (!index->verticals || !index->horizontals || !index->ys) {
+    free_polygon_index(index);
 
-  if (!is_inside_or_on_polygon(points, count, max_x, max_y))
     return false;
+  }
+
+  // Split the edges between consecutive red tiles by direction
+  for (int i = 0; i < count; i++) {
+    Point p1 = points[i];
+    Point p2 = points[(i + 1) % count];
 
-  // Check edges of rectangle with sampling for large rectangles
-  int width = max_x - min_x + 1;
-  int height = max_y - min_y + 1;
+    if (p1.x == p2.x && p1.y != p2.y) {
+      VEdge *e = &index->verticals[index->num_verticals++];
 
-  // For small rectangles, check every point
-  if (width <= 100 && height <= 100) {
-    for (int x = min_x; x <= max_x; x++) {
-      for (int y = min_y; y <= max_y; y++) {
-        if (!is_inside_or_on_polygon(points, count, x, y))
-          return false;
-      }
+      e->x = p1.x;
+      e->y1 = (p1.y < p2.y) ? p1.y : p2.y;
+      e->y2 = (p1.y > p2.y) ? p1.y : p2.y;
+    } else if (p1.y == p2.y && p1.x != p2.x) {
+      HEdge *e = &index->horizontals[index->num_horizontals++];
+
+      e->y = p1.y;
+      e->x1 = (p1.x < p2.x) ? p1.x : p2.x;
+      e->x2 = (p1.x > p2.x) ? p1.x : p2.x;
     }
 
-    return true;
+    index->ys[i] = p1.y;
   }
 
-  // For larger rectangles, sample a grid
-  int step = (width > height) ? (width / 50) : (height / 50);
+  qsort(index->horizontals, index->num_horizontals, sizeof(HEdge),
+        compare_hedges);
+
+  index->num_ys = unique_sorted(index->ys, count);
+  index->num_cells = 2 * index->num_ys - 1;
+
+  // Lay out each node's list in one array: count, offset, fill, then sort
+  int num_nodes = 4 * index->num_cells;
 
-  if (step < 1)
-    step = 1;
+  index->node_start = calloc(num_nodes + 1, sizeof(int));
+  if (!index->node_start) {
+    free_polygon_index(index);
+
+    return false;
+  }
+
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < index->num_verticals; i++) {
+      const VEdge *e = &index->verticals[i];
+
+      // A rightward ray at y crosses the edge when y1 <= y < y2
+      tree_insert(index, 0, 0, index->num_cells - 1, y_cell(index, e->y1),
+                  y_cell(index, e->y2) - 1, e->x, pass == 1);
+    }
+
+    if (pass == 0) {
+      for (int node = 0; node < num_nodes; node++)
+        index->node_start[node + 1] += index->node_start[node];
+
+      index->node_xs = malloc((index->node_start[num_nodes] + 1) * sizeof(int));
+      if (!index->node_xs) {
+        free_polygon_index(index);
 
-  for (int x = min_x; x <= max_x; x += step) {
-    for (int y = min_y; y <= max_y; y += step) {
-      if (!is_inside_or_on_polygon(points, count, x, y))
         return false;
+      }
     }
   }
 
-  // Carefully check the boundaries
-  for (int x = min_x; x <= max_x; x++) {
-    if (!is_inside_or_on_polygon(points, count, x, min_y))
-      return false;
+  // Filling moved every start to the next node's start: shift back
+  for (int node = num_nodes; node > 0; node--)
+    index->node_start[node] = index->node_start[node - 1];
+  index->node_start[0] = 0;
 
-    if (!is_inside_or_on_polygon(points, count, x, max_y))
-      return false;
+  for (int node = 0; node < num_nodes; node++) {
+    qsort(index->node_xs + index->node_start[node],
+          index->node_start[node + 1] - index->node_start[node], sizeof(int),
+          compare_ints);
   }
 
-  for (int y = min_y; y <= max_y; y++) {
-    if (!is_inside_or_on_polygon(points, count, min_x, y))
-      return false;
+  return true;
+}
 
-    if (!is_inside_or_on_polygon(points, count, max_x, y))
+// Classify a whole row of points at once: xs must be sorted ascending
+// The vertical edges crossing the row are gathered once and swept together
+// with the points, as are the horizontal edges lying on it. A vertical edge
+// that only ends on this row ends in a red tile on a horizontal edge here, so
+// the sweep covers the boundary without any per-point lookups.
+// Returns false on allocation failure.
+bool classify_row(const PolygonIndex *index, int py, const int *xs, int count,
+                  bool *inside) {
+  int cell = y_cell(index, py);
+  int *crossing = NULL;
+  int num_crossing = 0;
+
+  if (cell >= 0) {
+    crossing = malloc((index->num_verticals + 1) * sizeof(int));
+    if (!crossing)
       return false;
+
+    int node = 0, node_lo = 0, node_hi = index->num_cells - 1;
+
+    for (;;) {
+      for (int k = index->node_start[node]; k < index->node_start[node + 1];
+           k++)
+        crossing[num_crossing++] = index->node_xs[k];
+
+      if (node_lo == node_hi)
+        break;
+
+      int mid = node_lo + (node_hi - node_lo) / 2;
+
+      if (cell <= mid) {
+        node = 2 * node + 1;
+        node_hi = mid;
+      } else {
+        node = 2 * node + 2;
+        node_lo = mid + 1;
+      }
+    }
+
+    qsort(crossing, num_crossing, sizeof(int), compare_ints);
   }
 
+  // First horizontal edge on this row
+  int h = 0, lo = 0, hi = index->num_horizontals;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+
+    if (index->horizontals[mid].y < py)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  h = lo;
+
+  int passed = 0; // Crossing edges at or left of the current point
+
+  for (int i = 0; i < count; i++) {
+    int px = xs[i];
+
+    while (passed < num_crossing && crossing[passed] <= px)
+      passed++;
+
+    while (h < index->num_horizontals && index->horizontals[h].y == py &&
+           index->horizontals[h].x2 < px)
+      h++;
+
+    bool on_horizontal = h < index->num_horizontals &&
+                         index->horizontals[h].y == py &&
+                         index->horizontals[h].x1 <= px;
+
+    bool on_vertical = passed > 0 && crossing[passed - 1] == px;
+
+    inside[i] =
+        ((num_crossing - passed) % 2 == 1) || on_vertical || on_horizontal;
+  }
+
+  free(crossing);
+
   return true;
 }
+
+// Cell holding a distinct coordinate (always an even cell)
+int grid_index(const int *coords, int num_coords, int value) {
+  int lo = 0, hi = num_coords - 1;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+
+    if (coords[mid] < value)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return 2 * lo;
+}
+
+// First tile of a cell and whether the cell holds any tiles at all
+static bool cell_tile(const int *coords, int cell, int *tile) {
+  if (cell % 2 == 0) {
+    *tile = coords[cell / 2];
+
+    return true;
+  }
+
+  *tile = coords[cell / 2] + 1;
+
+  return *tile < coords[cell / 2 + 1];
+}
+
+void free_grid(CompressedGrid *grid) {
+  free(grid->xs);
+  free(grid->ys);
+  free(grid->bad_sum);
+}
+
+// Compress the coordinates, classify each cell once and build the prefix sum
+bool build_grid(CompressedGrid *grid, const PolygonIndex *index,
+                Point *points, int count) {
+  grid->xs = malloc(count * sizeof(int));
+  grid->ys = malloc(count * sizeof(int));
+  grid->bad_sum = NULL;
+
+  if (!grid->xs || !grid->ys) {
+    free_grid(grid);
+
+    return false;
+  }
+
+  for (int i = 0; i < count; i++) {
+    grid->xs[i] = points[i].x;
+    grid->ys[i] = points[i].y;
+  }
+
+  grid->num_xs = unique_sorted(grid->xs, count);
+  grid->num_ys = unique_sorted(grid->ys, count);
+  grid->width = 2 * grid->num_xs - 1;
+  grid->height = 2 * grid->num_ys - 1;
+
+  size_t stride = (size_t)grid->width + 1;
+  grid->bad_sum = calloc(stride * (grid->height + 1), sizeof(unsigned));
+
+  // One tile speaks for its whole cell: the row of them is classified in one
+  // sweep. Empty gap cells are never bad.
+  int *row_xs = malloc(grid->width * sizeof(int));
+  int *row_cells = malloc(grid->width * sizeof(int));
+  bool *row_inside = malloc(grid->width * sizeof(bool));
+  int row_count = 0;
+
+  if (!grid->bad_sum || !row_xs || !row_cells || !row_inside) {
+    free(row_xs);
+    free(row_cells);
+    free(row_inside);
+    free_grid(grid);
+
+    return false;
+  }
+
+  for (int cx = 0; cx < grid->width; cx++) {
+    int x;
+
+    if (cell_tile(grid->xs, cx, &x)) {
+      row_xs[row_count] = x;
+      row_cells[row_count] = cx;
+      row_count++;
+    }
+  }
+
+  bool ok = true;
+
+  for (int cy = 0; cy < grid->height && ok; cy++) {
+    int y;
+    unsigned *above = &grid->bad_sum[cy * stride];
+    unsigned *row = &grid->bad_sum[(cy + 1) * stride];
+
+    if (cell_tile(grid->ys, cy, &y)) {
+      ok = classify_row(index, y, row_xs, row_count, row_inside);
+    } else {
+      for (int k = 0; k < row_count; k++)
+        row_inside[k] = true;
+    }
+
+    for (int cx = 0, k = 0; cx < grid->width; cx++) {
+      bool bad = false;
+
+      if (k < row_count && row_cells[k] == cx)
+        bad = !row_inside[k++];
+
+      row[cx + 1] = bad + row[cx] + above[cx + 1] - above[cx];
+    }
+  }
+
+  free(row_xs);
+  free(row_cells);
+  free(row_inside);
+
+  if (!ok)
+    free_grid(grid);
+
+  return ok;
+}
+
+// Exact check: the rectangle of cells holds no cell outside the polygon
+bool check_rectangle_valid(const CompressedGrid *grid, int cx1, int cx2,
+                           int cy1, int cy2) {
+  size_t stride = (size_t)grid->width + 1;
+  const unsigned *sum = grid->bad_sum;
+
+  unsigned bad = sum[(cy2 + 1) * stride + cx2 + 1] -
+                 sum[cy1 * stride + cx2 + 1] - sum[(cy2 + 1) * stride + cx1] +
+                 sum[cy1 * stride + cx1];
+
+  return bad == 0;
+}
+
+// Sort corners by bound, largest first, then by input order
+int compare_corners(const void *a, const void *b) {
+  const Corner *ca = a, *cb = b;
+
+  if (ca->bound != cb->bound)
+    return (ca->bound < cb->bound) - (ca->bound > cb->bound);
+
+  return (ca->id > cb->id) - (ca->id < cb->id);
+}
+
+// Claim corners one at a time and check each against every later corner
+// Ties in area go to the pair earliest in input order, so the reported
+// corners don't depend on thread timing. Every task runs the same search, so
+// the index doesn't matter.
+void search_task(void *ctx, int index) {
+  RectangleSearch *search = ctx;
+  (void)index;
+  const Corner *corners = search->corners;
+  int count = search->count;
+  int step = count / 20 > 0 ? count / 20 : 1;
+
+  for (;;) {
+    int i = atomic_fetch_add_explicit(&search->next_corner, 1,
+                                      memory_order_relaxed);
+    if (i >= count)
+      break;
+
+    long long best = atomic_load_explicit(&search->max_area,
+                                          memory_order_relaxed);
+
+    // Every later corner has a bound at most this one's
+    if (corners[i].bound < best)
+      break;
+
+    const Corner *a = &corners[i];
+
+    for (int j = i + 1; j < count; j++) {
+      const Corner *b = &corners[j];
+
+      // Bounds only shrink from here on
+      if (b->bound < best)
+        break;
+
+      long long width = (a->x > b->x ? a->x - b->x : b->x - a->x) + 1;
+      long long height = (a->y > b->y ? a->y - b->y : b->y - a->y) + 1;
+      long long area = width * height;
+
+      if (area < best)
+        continue;
+
+      int cx1 = a->cell_x < b->cell_x ? a->cell_x : b->cell_x;
+      int cx2 = a->cell_x > b->cell_x ? a->cell_x : b->cell_x;
+      int cy1 = a->cell_y < b->cell_y ? a->cell_y : b->cell_y;
+      int cy2 = a->cell_y > b->cell_y ? a->cell_y : b->cell_y;
+
+      if (!check_rectangle_valid(search->grid, cx1, cx2, cy1, cy2))
+        continue;
+
+      pthread_mutex_lock(&search->best_lock);
+
+      long long current = atomic_load(&search->max_area);
+      int lo = a->id < b->id ? a->id : b->id;
+      int hi = a->id < b->id ? b->id : a->id;
+      bool better = area > current || search->best_a < 0;
+
+      if (!better && area == current) {
+        const Corner *ba = &corners[search->best_a];
+        const Corner *bb = &corners[search->best_b];
+        int best_lo = ba->id < bb->id ? ba->id : bb->id;
+        int best_hi = ba->id < bb->id ? bb->id : ba->id;
+
+        better = lo < best_lo || (lo == best_lo && hi < best_hi);
+      }
+
+      if (better) {
+        atomic_store(&search->max_area, area);
+        search->best_a = i;
+        search->best_b = j;
+      }
+
+      pthread_mutex_unlock(&search->best_lock);
+
+      best = atomic_load_explicit(&search->max_area, memory_order_relaxed);
+    }
+
+    if (search->progress) {
+      int done = atomic_fetch_add_explicit(&search->corners_done, 1,
+                                           memory_order_relaxed) +
+                 1;
+
+      if (done % step == 0 || done == count)
+        fprintf(stderr, "\rProcessing tiles: %d/%d corners checked", done,
+                count);
+    }
+  }
+}
@@ -0,0 +1,423 @@
+/*
+ * Routine: Advent of Code--Parsed Input Cache
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * Keeps a day's parsed input in a binary file, so a warm run maps it and
+ * works straight from it without touching the text. Off unless
+ * AOC_INPUT_CACHE names a directory to keep the files in; it's created if
+ * need be. Each file is named after the day, the representation's version
+ * and a hash of the input, and holds a header and up to INPUT_CACHE_SECTIONS
+ * sections, each 64-byte aligned.
+ *
+ * The header names the representation (a day and a version, bumped whenever
+ * the layout changes), the input's size and a hash of its bytes, and any
+ * parameters the representation depends on. A cache file that doesn't match
+ * on all of them is a miss: the day parses as usual and stores a new one.
+ * Nothing about the cache is ever fatal; a failure only costs the next run
+ * its parse.
+ *
+ * Needs _POSIX_C_SOURCE 200809L.
+ */
+
+#ifndef INPUT_CACHE_H
+#define INPUT_CACHE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INPUT_CACHE_MAGIC "AOCINPT\001" // Bump the last byte on change
+#define INPUT_CACHE_SECTIONS 8
+#define INPUT_CACHE_ALIGN 64
+
+// Representation of one day's input, shared by both of its parts
+#define INPUT_CACHE_KIND(day, version) ((uint32_t)(day) << 16 | (version))
+
+typedef struct {
+  char magic[8];
+  uint32_t kind;
+  uint32_t num_sections;
+  uint64_t input_size, input_hash;
+  uint64_t params;
+  uint64_t offsets[INPUT_CACHE_SECTIONS], sizes[INPUT_CACHE_SECTIONS];
+} InputCacheHeader;
+
+typedef struct {
+  const char *filename;
+  const char *text; // The input, mapped; NULL when it's empty
+  size_t size;
+  uint64_t hash, params;
+  uint32_t kind;
+
+  char *path;                     // Cache file, NULL when caching is off
+  void *mapping;                  // Cache file, mapped on a hit
+  size_t mapping_size;
+  const InputCacheHeader *header; // NULL on a miss
+
+  // A cache file being written
+  FILE *out;
+  char *temp;
+  InputCacheHeader pending;
+  uint64_t written;
+  int failed;
+} InputCache;
+
+static inline uint64_t input_cache_mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return h;
+}
+
+// 64-bit hash of size bytes, four independent lanes of 8 bytes at a time
+static inline uint64_t input_cache_hash(const void *data, size_t size) {
+  const unsigned char *bytes = data;
+  uint64_t lanes[4] = {0x243f6a8885a308d3ULL, 0x13198a2e03707344ULL,
+                       0xa4093822299f31d0ULL, 0x082efa98ec4e6c89ULL};
+  unsigned char tail[32] = {0};
+  size_t whole = size / 32 * 32;
+
+  for (size_t i = 0; i <= whole; i += 32) {
+    const unsigned char *block = bytes + i;
+
+    // The last, partial block is padded with zeros
+    if (i == whole) {
+      if (size == whole)
+        break;
+      memcpy(tail, bytes + i, size - whole);
+      block = tail;
+    }
+
+    for (int l = 0; l < 4; l++) {
+      uint64_t word;
+
+      memcpy(&word, block + 8 * l, 8);
+      lanes[l] = (lanes[l] ^ word) * 0x9e3779b97f4a7c15ULL;
+      lanes[l] ^= lanes[l] >> 29;
+    }
+  }
+
+  uint64_t h = size;
+
+  for (int l = 0; l < 4; l++)
+    h = input_cache_mix(h ^ lanes[l]);
+
+  return h;
+}
+
+// Map the cache file and check it belongs to this input, return 0 if not
+static inline int input_cache_map(InputCache *cache) {
+  int fd = open(cache->path, O_RDONLY);
+  struct stat st;
+
+  if (fd < 0)
+    return 0;
+
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(InputCacheHeader)) {
+    close(fd);
+
+    return 0;
+  }
+
+  size_t size = (size_t)st.st_size;
+  void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close(fd);
+
+  if (mapping == MAP_FAILED)
+    return 0;
+
+  const InputCacheHeader *header = mapping;
+  int ok = memcmp(header->magic, INPUT_CACHE_MAGIC, 8) == 0 &&
+           header->kind == cache->kind &&
+           header->num_sections <= INPUT_CACHE_SECTIONS &&
+           header->input_size == cache->size &&
+           header->input_hash == cache->hash &&
+           header->params == cache->params;
+
+  for (uint32_t i = 0; ok && i < header->num_sections; i++)
+    ok = header->offsets[i] % INPUT_CACHE_ALIGN == 0 &&
+         header->offsets[i] <= size &&
+         header->sizes[i] <= size - header->offsets[i];
+
+  if (!ok) {
+    munmap(mapping, size);
+
+    return 0;
+  }
+
+  cache->mapping = mapping;
+  cache->mapping_size = size;
+  cache->header = header;
+
+  return 1;
+}
+
+// Map the input, hash it and look for its cache file
+// params covers anything besides the input the representation depends on.
+// Returns 0 if the input can't be read; a missing or stale cache file is
+// only a miss.
+static inline int input_cache_open(InputCache *cache, const char *filename,
+                                   uint32_t kind, uint64_t params) {
+  memset(cache, 0, sizeof(*cache));
+  cache->filename = filename;
+  cache->kind = kind;
+  cache->params = params;
+
+  int fd = open(filename, O_RDONLY);
+  struct stat st;
+
+  if (fd < 0)
+    return 0;
+
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+
+    return 0;
+  }
+
+  cache->size = (size_t)st.st_size;
+
+  if (cache->size > 0) {
+    void *text = mmap(NULL, cache->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (text == MAP_FAILED) {
+      close(fd);
+
+      return 0;
+    }
+
+    cache->text = text;
+  }
+
+  close(fd);
+
+  const char *dir = getenv("AOC_INPUT_CACHE");
+  if (!dir || !*dir)
+    return 1;
+
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+    return 1;
+
+  cache->path = malloc(strlen(dir) + 64);
+  if (!cache->path)
+    return 1;
+
+  cache->hash = input_cache_hash(cache->text, cache->size);
+  sprintf(cache->path, "%s/day%02u-v%u-%016llx", dir, kind >> 16,
+          kind & 0xffff, (unsigned long long)cache->hash);
+  input_cache_map(cache);
+
+  return 1;
+}
+
+static inline int input_cache_hit(const InputCache *cache) {
+  return cache->header != NULL;
+}
+
+// Section i of a hit, and its size in bytes
+static inline const void *input_cache_section(const InputCache *cache, int i,
+                                              size_t *size) {
+  if (i >= (int)cache->header->num_sections) {
+    *size = 0;
+
+    return NULL;
+  }
+
+  *size = cache->header->sizes[i];
+
+  return (const char *)cache->mapping + cache->header->offsets[i];
+}
+
+// Drop a hit whose sections don't hold together, so the day parses instead
+static inline void input_cache_reject(InputCache *cache) {
+  if (cache->mapping)
+    munmap(cache->mapping, cache->mapping_size);
+
+  cache->mapping = NULL;
+  cache->header = NULL;
+}
+
+// The input as a stream, for days that parse with stdio
+static inline FILE *input_cache_fopen(const InputCache *cache) {
+  if (cache->size == 0)
+    return fopen(cache->filename, "r");
+
+  return fmemopen((void *)cache->text, cache->size, "r");
+}
+
+// Start writing a new cache file, beside the old one until it's complete
+static inline void input_cache_begin(InputCache *cache) {
+  cache->failed = 1;
+
+  if (!cache->path)
+    return;
+
+  cache->temp = malloc(strlen(cache->path) + 32);
+  if (!cache->temp)
+    return;
+
+  sprintf(cache->temp, "%s.%ld.tmp", cache->path, (long)getpid());
+
+  cache->out = fopen(cache->temp, "wb");
+  if (!cache->out)
+    return;
+
+  memset(&cache->pending, 0, sizeof(cache->pending));
+  memcpy(cache->pending.magic, INPUT_CACHE_MAGIC, 8);
+  cache->pending.kind = cache->kind;
+  cache->pending.input_size = cache->size;
+  cache->pending.input_hash = cache->hash;
+  cache->pending.params = cache->params;
+
+  // The header goes in last, once the sections are placed
+  cache->written = sizeof(InputCacheHeader);
+  cache->failed = fseek(cache->out, (long)cache->written, SEEK_SET) != 0;
+}
+
+// Append size bytes to section i; sections are written in order
+static inline void input_cache_append(InputCache *cache, int i,
+                                      const void *data, size_t size) {
+  InputCacheHeader *header = &cache->pending;
+
+  if (cache->failed || i >= INPUT_CACHE_SECTIONS ||
+      i < (int)header->num_sections - 1) {
+    cache->failed = 1;
+
+    return;
+  }
+
+  // A new section starts aligned, after any it skipped over
+  while ((int)header->num_sections <= i) {
+    static const char padding[INPUT_CACHE_ALIGN];
+    size_t pad = (INPUT_CACHE_ALIGN - cache->written % INPUT_CACHE_ALIGN) %
+                 INPUT_CACHE_ALIGN;
+
+    if (fwrite(padding, 1, pad, cache->out) != pad) {
+      cache->failed = 1;
+
+      return;
+    }
+
+    cache->written += pad;
+    header->offsets[header->num_sections] = cache->written;
+    header->sizes[header->num_sections++] = 0;
+  }
+
+  if (size && fwrite(data, 1, size, cache->out) != size) {
+    cache->failed = 1;
+
+    return;
+  }
+
+  header->sizes[i] += size;
+  cache->written += size;
+}
+
+// Write the header and put the finished file in place of the old one
+static inline void input_cache_commit(InputCache *cache) {
+  int ok = !cache->failed && fseek(cache->out, 0, SEEK_SET) == 0 &&
+           fwrite(&cache->pending, sizeof(cache->pending), 1, cache->out) == 1;
+
+  if (cache->out && fclose(cache->out) != 0)
+    ok = 0;
+
+  if (cache->temp && (!ok || rename(cache->temp, cache->path) != 0))
+    remove(cache->temp);
+
+  free(cache->temp);
+  cache->out = NULL;
+  cache->temp = NULL;
+}
+
+// Store count whole sections in one go
+static inline void input_cache_store(InputCache *cache, int count,
+                                     const void *const *data,
+                                     const size_t *sizes) {
+  input_cache_begin(cache);
+
+  for (int i = 0; i < count; i++)
+    input_cache_append(cache, i, data[i], sizes[i]);
+
+  input_cache_commit(cache);
+}
+
+static inline void input_cache_close(InputCache *cache) {
+  if (cache->out)
+    input_cache_commit(cache);
+
+  input_cache_reject(cache);
+
+  if (cache->text)
+    munmap((void *)cache->text, cache->size);
+
+  free(cache->path);
+  cache->text = NULL;
+  cache->path = NULL;
+}
+
+// A grid of NUL-terminated rows, stride bytes apart, as two sections: the
+// row lengths, then the rows packed end to end
+static inline void input_cache_store_grid(InputCache *cache, const char *grid,
+                                          size_t stride, int rows) {
+  input_cache_begin(cache);
+
+  for (int r = 0; r < rows; r++) {
+    int32_t length = (int32_t)strlen(grid + r * stride);
+
+    input_cache_append(cache, 0, &length, sizeof(length));
+  }
+
+  for (int r = 0; r < rows; r++)
+    input_cache_append(cache, 1, grid + r * stride, strlen(grid + r * stride));
+
+  input_cache_commit(cache);
+}
+
+// Unpack a stored grid into grid, return its rows or -1 if it doesn't fit
+// *cols, if given, gets the longest row.
+static inline int input_cache_load_grid(const InputCache *cache, char *grid,
+                                        size_t stride, int max_rows,
+                                        int *cols) {
+  size_t lengths_size, packed_size;
+  const int32_t *lengths = input_cache_section(cache, 0, &lengths_size);
+  const char *packed = input_cache_section(cache, 1, &packed_size);
+  int rows = (int)(lengths_size / sizeof(int32_t));
+  size_t used = 0;
+
+  if (!lengths || !packed || rows > max_rows)
+    return -1;
+
+  if (cols)
+    *cols = 0;
+
+  for (int r = 0; r < rows; r++) {
+    size_t length = (size_t)lengths[r];
+
+    if (lengths[r] < 0 || length >= stride || length > packed_size - used)
+      return -1;
+
+    memcpy(grid + r * stride, packed + used, length);
+    grid[r * stride + length] = '\0';
+    used += length;
+
+    if (cols && lengths[r] > *cols)
+      *cols = lengths[r];
+  }
+
+  return rows;
+}
+
+#endif
@@ -0,0 +1,277 @@
+/*
+ * Routine: Advent of Code--Result Cache
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * Remembers what a solver printed, so a run on the same input replays it
+ * instead of solving again. Off unless AOC_RESULT_CACHE names a directory
+ * to keep the results in; it's created if need be.
+ *
+ * A result is keyed by day, part, solver version, the arguments that change
+ * what the solver prints and a hash of the input's bytes, one file per key.
+ * Arguments that only affect stderr are left out of the key. Each day
+ * defines its own version, to bump whenever a change could alter what it
+ * prints. Every run reports on stderr whether it hit, with the hit and miss
+ * counts kept in the directory's "stats" file, so the scheduler can see how
+ * much solving it saved.
+ *
+ * Whatever a solver prints to stdout has to go through result_printf(),
+ * and only a run that calls result_cache_finish() stores its result, so
+ * failed runs are never replayed.
+ *
+ * Needs _POSIX_C_SOURCE 200809L.
+ */
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "input_cache.h"
+
+typedef struct {
+  char *dir;  // NULL when the cache is off
+  char *path; // This run's result
+  struct timespec start;
+
+  // Everything printed so far, stored on a miss
+  char *output;
+  size_t used, capacity;
+  int failed; // Some output was lost, so there's nothing to store
+} ResultCache;
+
+static inline double result_cache_micros(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (now.tv_sec - start->tv_sec) * 1e6 +
+         (now.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+// Hash of a whole file, return 0 if it can't be read
+static inline int result_cache_hash_file(const char *filename,
+                                         uint64_t *hash) {
+  int fd = open(filename, O_RDONLY);
+  struct stat st;
+
+  if (fd < 0)
+    return 0;
+
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+
+    return 0;
+  }
+
+  size_t size = (size_t)st.st_size;
+  void *text = NULL;
+
+  if (size > 0) {
+    text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (text == MAP_FAILED) {
+      close(fd);
+
+      return 0;
+    }
+  }
+
+  close(fd);
+
+  *hash = input_cache_hash(text, size);
+
+  if (text)
+    munmap(text, size);
+
+  return 1;
+}
+
+// Count a hit or a miss in the directory's stats file and report both
+// totals; the file is locked, since runs may share the directory.
+static inline void result_cache_count(const ResultCache *cache, int hit,
+                                      const char *what) {
+  char *path = malloc(strlen(cache->dir) + sizeof("/stats"));
+  char text[64] = {0};
+  long long hits = 0, misses = 0;
+  int fd = -1;
+
+  if (path) {
+    sprintf(path, "%s/stats", cache->dir);
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    free(path);
+  }
+
+  struct flock lock;
+
+  memset(&lock, 0, sizeof(lock));
+  lock.l_type = F_WRLCK;
+  lock.l_whence = SEEK_SET;
+
+  if (fd >= 0 && fcntl(fd, F_SETLKW, &lock) == 0) {
+    if (pread(fd, text, sizeof(text) - 1, 0) > 0)
+      sscanf(text, "%lld %lld", &hits, &misses);
+
+    if (hit)
+      hits++;
+    else
+      misses++;
+
+    int n = snprintf(text, sizeof(text), "%lld %lld\n", hits, misses);
+
+    if (pwrite(fd, text, n, 0) != n || ftruncate(fd, n) != 0)
+      hits = misses = -1;
+  }
+
+  if (fd >= 0)
+    close(fd);
+
+  fprintf(stderr, "Result cache: %s in %.1f us (%lld hits, %lld misses)\n",
+          what, result_cache_micros(&cache->start), hits, misses);
+}
+
+// Look up this run's result
+// Returns 1 on a hit, after printing the stored output: the solver is done.
+// Otherwise the solver runs as usual, printing through result_printf().
+static inline int result_cache_open(ResultCache *cache, const char *filename,
+                                    int day, int part, int version, int argc,
+                                    char *argv[]) {
+  memset(cache, 0, sizeof(*cache));
+  clock_gettime(CLOCK_MONOTONIC, &cache->start);
+
+  const char *dir = getenv("AOC_RESULT_CACHE");
+  uint64_t input_hash, args_hash = 0;
+
+  if (!dir || !*dir || !result_cache_hash_file(filename, &input_hash))
+    return 0;
+
+  // Arguments, each with its NUL, so "a b" and "ab" differ
+  for (int i = 1; i < argc; i++)
+    args_hash = input_cache_mix(
+        args_hash ^ input_cache_hash(argv[i], strlen(argv[i]) + 1));
+
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+    return 0;
+
+  cache->dir = malloc(strlen(dir) + 1);
+  cache->path = malloc(strlen(dir) + 64);
+  if (!cache->dir || !cache->path) {
+    free(cache->dir);
+    free(cache->path);
+    cache->dir = cache->path = NULL;
+
+    return 0;
+  }
+
+  strcpy(cache->dir, dir);
+  sprintf(cache->path, "%s/day%02d-part%d-v%d-%016llx-%016llx", dir, day,
+          part, version, (unsigned long long)input_hash,
+          (unsigned long long)args_hash);
+
+  FILE *fp = fopen(cache->path, "rb");
+  if (!fp)
+    return 0;
+
+  // Replay the result
+  char buffer[65536];
+  size_t got;
+
+  while ((got = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    fwrite(buffer, 1, got, stdout);
+
+  fclose(fp);
+  fflush(stdout);
+
+  result_cache_count(cache, 1, "hit, replayed");
+  free(cache->dir);
+  free(cache->path);
+  cache->dir = cache->path = NULL;
+
+  return 1;
+}
+
+// printf() that also keeps the output for the cache
+static inline void result_printf(ResultCache *cache, const char *format, ...) {
+  va_list args;
+
+  va_start(args, format);
+
+  if (cache->dir) {
+    va_list copy;
+
+    va_copy(copy, args);
+    int length = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+
+    if (length >= 0 && cache->used + length + 1 > cache->capacity) {
+      size_t capacity = cache->capacity ? cache->capacity * 2 : 4096;
+
+      while (capacity < cache->used + length + 1)
+        capacity *= 2;
+
+      char *grown = realloc(cache->output, capacity);
+      if (grown) {
+        cache->output = grown;
+        cache->capacity = capacity;
+      }
+    }
+
+    // Running short of memory only loses the result, not the output
+    va_copy(copy, args);
+    if (length >= 0 && cache->used + length + 1 <= cache->capacity)
+      cache->used += vsnprintf(cache->output + cache->used, length + 1, format,
+                               copy);
+    else
+      cache->failed = 1;
+    va_end(copy);
+  }
+
+  vprintf(format, args);
+  va_end(args);
+}
+
+// Store the output of a successful run for the next one
+static inline void result_cache_finish(ResultCache *cache) {
+  char *temp = cache->dir ? malloc(strlen(cache->path) + 32) : NULL;
+
+  if (temp && !cache->failed) {
+    sprintf(temp, "%s.%ld.tmp", cache->path, (long)getpid());
+
+    FILE *fp = fopen(temp, "wb");
+    int ok = fp != NULL;
+
+    if (fp) {
+      ok = cache->used == 0 ||
+           fwrite(cache->output, 1, cache->used, fp) == cache->used;
+      ok = fclose(fp) == 0 && ok;
+    }
+
+    if (!ok || rename(temp, cache->path) != 0)
+      remove(temp);
+  }
+
+  if (cache->dir) {
+    fflush(stdout);
+    result_cache_count(cache, 0, "miss, solved");
+  }
+
+  free(temp);
+
+  free(cache->dir);
+  free(cache->path);
+  free(cache->output);
+  memset(cache, 0, sizeof(*cache));
+}
+
+#endif
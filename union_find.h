@@ -0,0 +1,130 @@
+/*
+ * Routine: Advent of Code--Disjoint Set (Union-Find)
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * Union by size with path halving. Besides the usual find/union it keeps a
+ * live count of components and a packed list of their roots, so sizes and
+ * the largest components can be read without walking every element.
+ */
+
+#ifndef UNION_FIND_H
+#define UNION_FIND_H
+
+#include <stdlib.h>
+
+typedef struct {
+  int *parent;
+  int *size;     // Component size, valid at roots
+  int *roots;    // Current roots, packed
+  int *root_pos; // Position of each root in roots[]
+  int count;
+  int components;
+} UnionFind;
+
+static inline void uf_free(UnionFind *uf) {
+  free(uf->parent);
+  free(uf->size);
+  free(uf->roots);
+  free(uf->root_pos);
+
+  uf->parent = uf->size = uf->roots = uf->root_pos = NULL;
+}
+
+// Start with every element in its own component, return 0 on allocation
+// failure
+static inline int uf_init(UnionFind *uf, int n) {
+  size_t bytes = (n > 0 ? n : 1) * sizeof(int);
+
+  uf->parent = malloc(bytes);
+  uf->size = malloc(bytes);
+  uf->roots = malloc(bytes);
+  uf->root_pos = malloc(bytes);
+  uf->count = n;
+  uf->components = n;
+
+  if (!uf->parent || !uf->size || !uf->roots || !uf->root_pos) {
+    uf_free(uf);
+
+    return 0;
+  }
+
+  for (int i = 0; i < n; i++) {
+    uf->parent[i] = i;
+    uf->size[i] = 1;
+    uf->roots[i] = i;
+    uf->root_pos[i] = i;
+  }
+
+  return 1;
+}
+
+static inline int uf_find(UnionFind *uf, int x) {
+  while (uf->parent[x] != x) {
+    // Path halving: point every other node at its grandparent
+    uf->parent[x] = uf->parent[uf->parent[x]];
+    x = uf->parent[x];
+  }
+
+  return x;
+}
+
+// Returns 1 if union was performed, 0 if they were already in same set
+static inline int uf_union(UnionFind *uf, int x, int y) {
+  int root_x = uf_find(uf, x);
+  int root_y = uf_find(uf, y);
+
+  if (root_x == root_y)
+    return 0;
+
+  // Union by size: hang the smaller tree under the larger
+  if (uf->size[root_x] < uf->size[root_y]) {
+    int tmp = root_x;
+    root_x = root_y;
+    root_y = tmp;
+  }
+
+  uf->parent[root_y] = root_x;
+  uf->size[root_x] += uf->size[root_y];
+
+  // root_y is no longer a root: move the last root into its slot
+  int pos = uf->root_pos[root_y];
+  int moved = uf->roots[--uf->components];
+
+  uf->roots[pos] = moved;
+  uf->root_pos[moved] = pos;
+
+  return 1;
+}
+
+// Size of the component holding x
+static inline int uf_size(UnionFind *uf, int x) {
+  return uf->size[uf_find(uf, x)];
+}
+
+// Write the sizes of the k largest components to out, largest first
+// Only the current roots are visited. Returns how many sizes were written.
+static inline int uf_top_sizes(const UnionFind *uf, int k, int *out) {
+  int filled = 0;
+
+  for (int i = 0; i < uf->components; i++) {
+    int size = uf->size[uf->roots[i]];
+    int j = filled < k ? filled++ : k;
+
+    // Insertion into the short sorted list
+    while (j > 0 && out[j - 1] < size) {
+      if (j < k)
+        out[j] = out[j - 1];
+      j--;
+    }
+
+    if (j < k)
+      out[j] = size;
+  }
+
+  return filled;
+}
+
+#endif
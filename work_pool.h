@@ -0,0 +1,161 @@
+/*
+ * Routine: Advent of Code--Work-Stealing Thread Pool
+ *
+ * Author: DannyBimma
+ *
+ * Copyright (c) 2025 Technomancer Pirate Caption. All Rights Reserved.
+ *
+ * Runs a task for every index of a batch across all cores. Each worker
+ * starts with an even slice of the indices and takes them from the front;
+ * once its slice is empty it steals the back half of another worker's, so a
+ * few slow tasks never leave the other cores idle. Tasks write their results
+ * by index, so callers can reduce them in input order afterwards.
+ *
+ * Needs _POSIX_C_SOURCE 200809L and -pthread.
+ */
+
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef void (*PoolTaskFn)(void *ctx, int index);
+
+// Indices still waiting in one worker's slice
+typedef struct {
+  pthread_mutex_t lock;
+  int begin, end;
+} PoolQueue;
+
+typedef struct {
+  PoolQueue *queues;
+  int num_queues;
+  PoolTaskFn fn;
+  void *ctx;
+} WorkPool;
+
+typedef struct {
+  WorkPool *pool;
+  int id;
+} PoolWorker;
+
+static inline int pool_num_workers(void) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return cpus < 1 ? 1 : (int)cpus;
+}
+
+// Take the next index from the front of a queue, return 0 if it's empty
+static inline int pool_take(PoolQueue *queue, int *index) {
+  int found = 0;
+
+  pthread_mutex_lock(&queue->lock);
+  if (queue->begin < queue->end) {
+    *index = queue->begin++;
+    found = 1;
+  }
+  pthread_mutex_unlock(&queue->lock);
+
+  return found;
+}
+
+// Move the back half of some other queue into an empty one
+// Tasks never add work, so once every queue is empty the batch is done.
+static inline int pool_steal(WorkPool *pool, int self) {
+  for (int i = 1; i < pool->num_queues; i++) {
+    PoolQueue *victim = &pool->queues[(self + i) % pool->num_queues];
+    int begin = 0, end = 0;
+
+    pthread_mutex_lock(&victim->lock);
+    int left = victim->end - victim->begin;
+    if (left > 0) {
+      end = victim->end;
+      begin = end - (left + 1) / 2;
+      victim->end = begin;
+    }
+    pthread_mutex_unlock(&victim->lock);
+
+    if (begin < end) {
+      PoolQueue *own = &pool->queues[self];
+
+      pthread_mutex_lock(&own->lock);
+      own->begin = begin;
+      own->end = end;
+      pthread_mutex_unlock(&own->lock);
+
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static inline void *pool_worker(void *arg) {
+  PoolWorker *worker = arg;
+  WorkPool *pool = worker->pool;
+  int index;
+
+  do {
+    while (pool_take(&pool->queues[worker->id], &index))
+      pool->fn(pool->ctx, index);
+  } while (pool_steal(pool, worker->id));
+
+  return NULL;
+}
+
+// Run fn(ctx, i) for every i in [0, count) and wait for all of them
+// The calling thread works too. Without memory for the pool the batch simply
+// runs in order on the calling thread.
+static inline void pool_run(int count, PoolTaskFn fn, void *ctx) {
+  int threads = pool_num_workers();
+  if (threads > count)
+    threads = count;
+
+  WorkPool pool = {NULL, threads, fn, ctx};
+  PoolWorker *workers = malloc(threads * sizeof(PoolWorker));
+  pthread_t *ids = malloc(threads * sizeof(pthread_t));
+  int *started = malloc(threads * sizeof(int));
+  pool.queues = malloc(threads * sizeof(PoolQueue));
+
+  if (threads < 2 || !workers || !ids || !started || !pool.queues) {
+    free(workers);
+    free(ids);
+    free(started);
+    free(pool.queues);
+
+    for (int i = 0; i < count; i++)
+      fn(ctx, i);
+
+    return;
+  }
+
+  for (int t = 0; t < threads; t++) {
+    pthread_mutex_init(&pool.queues[t].lock, NULL);
+    pool.queues[t].begin = (int)((long long)count * t / threads);
+    pool.queues[t].end = (int)((long long)count * (t + 1) / threads);
+    workers[t].pool = &pool;
+    workers[t].id = t;
+  }
+
+  // A thread that fails to start just has its slice stolen by the others
+  for (int t = 1; t < threads; t++)
+    started[t] = pthread_create(&ids[t], NULL, pool_worker, &workers[t]) == 0;
+
+  pool_worker(&workers[0]);
+
+  for (int t = 1; t < threads; t++)
+    if (started[t])
+      pthread_join(ids[t], NULL);
+
+  for (int t = 0; t < threads; t++)
+    pthread_mutex_destroy(&pool.queues[t].lock);
+
+  free(workers);
+  free(ids);
+  free(started);
+  free(pool.queues);
+}
+
+#endif